@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file feature_cost.cpp
+    Cost per sample added to accumulators of each feature level, for scalar and vector samples
+*/
+
+#include <alps/accumulators.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    /// Samples with some structure, so that the binning does not see constants
+    double gen(long i) { return std::sin(0.37*i)+0.5; }
+}
+
+/// Each iteration adds one scalar sample to the accumulator
+template <typename A>
+void BM_add_scalar(benchmark::State& state) {
+    const A named("x");
+    typename A::accumulator_type& acc=named.wrapper->template extract<typename A::accumulator_type>();
+
+    long i=0;
+    for (auto _ : state) {
+        acc(gen(i++));
+    }
+    benchmark::DoNotOptimize(acc.count());
+    state.SetItemsProcessed(state.iterations());
+}
+
+/// Each iteration adds one vector sample of `state.range(0)` elements to the accumulator
+template <typename A>
+void BM_add_vector(benchmark::State& state) {
+    const A named("x");
+    typename A::accumulator_type& acc=named.wrapper->template extract<typename A::accumulator_type>();
+    std::vector<double> v(state.range(0));
+
+    long i=0;
+    for (auto _ : state) {
+        v[0]=gen(i++);
+        acc(v);
+    }
+    benchmark::DoNotOptimize(acc.count());
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations()*v.size()*sizeof(double));
+}
+
+/// Same as BM_add_scalar, through the type-erased wrapper of an accumulator set
+template <typename A>
+void BM_add_scalar_wrapped(benchmark::State& state) {
+    aa::accumulator_set mset;
+    mset << A("x");
+    aa::accumulator_wrapper& acc=mset["x"];
+
+    long i=0;
+    for (auto _ : state) {
+        acc << gen(i++);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_add_scalar, aa::MeanAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_scalar, aa::NoBinningAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_scalar, aa::LogBinningAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_scalar, aa::FullBinningAccumulator<double>);
+
+BENCHMARK_TEMPLATE(BM_add_scalar_wrapped, aa::MeanAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_scalar_wrapped, aa::FullBinningAccumulator<double>);
+
+BENCHMARK_TEMPLATE(BM_add_vector, aa::MeanAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_add_vector, aa::NoBinningAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_add_vector, aa::LogBinningAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_add_vector, aa::FullBinningAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096);
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file mpi_merge.cpp
+    Time of the collective merge of an accumulator set over all processes
+
+    All processes run the same, fixed number of iterations; only the root reports.
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/utilities/mpi.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const std::size_t nobservables=20;
+
+    std::string name(std::size_t i) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "Observable_%04lu", static_cast<unsigned long>(i));
+        return buf;
+    }
+
+    template <typename A>
+    void fill_set(aa::accumulator_set& mset, std::size_t nelements, int nsamples, int rank) {
+        for (std::size_t k=0; k<nobservables; ++k)
+            mset << A(name(k));
+        std::vector<double> v(nelements);
+        for (int i=0; i<nsamples; ++i) {
+            for (std::size_t j=0; j<nelements; ++j) v[j]=std::sin(0.37*i+j+rank);
+            for (std::size_t k=0; k<nobservables; ++k) mset[name(k)] << v;
+        }
+    }
+
+    /// Reports nothing, for the processes other than the root
+    class null_reporter : public benchmark::BenchmarkReporter {
+      public:
+        bool ReportContext(const Context&) { return true; }
+        void ReportRuns(const std::vector<Run>&) {}
+    };
+}
+
+/// Each iteration merges the sets of all processes with `accumulator_set::collective_merge`
+template <typename A>
+void BM_collective_merge(benchmark::State& state) {
+    alps::mpi::communicator comm;
+    aa::accumulator_set mset;
+    fill_set<A>(mset, state.range(0), 1000, comm.rank());
+
+    for (auto _ : state) {
+        mset.collective_merge(comm, 0);
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+/// Same as BM_collective_merge, merging each accumulator by itself
+template <typename A>
+void BM_collective_merge_each(benchmark::State& state) {
+    alps::mpi::communicator comm;
+    aa::accumulator_set mset;
+    fill_set<A>(mset, state.range(0), 1000, comm.rank());
+
+    for (auto _ : state) {
+        for (std::size_t k=0; k<nobservables; ++k)
+            mset[name(k)].collective_merge(comm, 0);
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+BENCHMARK_TEMPLATE(BM_collective_merge, aa::MeanAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096)->Iterations(100);
+BENCHMARK_TEMPLATE(BM_collective_merge, aa::FullBinningAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096)->Iterations(100);
+BENCHMARK_TEMPLATE(BM_collective_merge_each, aa::MeanAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096)->Iterations(100);
+BENCHMARK_TEMPLATE(BM_collective_merge_each, aa::FullBinningAccumulator< std::vector<double> >)->RangeMultiplier(16)->Range(1, 4096)->Iterations(100);
+
+int main(int argc, char** argv) {
+    alps::mpi::environment env(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (alps::mpi::communicator().rank()==0) {
+        benchmark::RunSpecifiedBenchmarks();
+    } else {
+        null_reporter display, file;
+        benchmark::RunSpecifiedBenchmarks(&display, &file);
+    }
+    benchmark::Shutdown();
+    return 0;
+}
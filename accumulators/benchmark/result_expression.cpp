@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file result_expression.cpp
+    Cost of evaluating the Binder cumulant of full binning results, operation by operation and deferred
+*/
+
+#include <alps/accumulators.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    void fill(aa::accumulator_set& mset, int max_bins) {
+        mset << aa::FullBinningAccumulator<double>("m2", aa::max_bin_number=max_bins)
+             << aa::FullBinningAccumulator<double>("m4", aa::max_bin_number=max_bins);
+        for (int i=0; i<100*max_bins; ++i) {
+            const double m=std::sin(0.37*i);
+            mset["m2"] << m*m;
+            mset["m4"] << m*m*m*m;
+        }
+    }
+}
+
+/// Each iteration evaluates `1-m4/(3*m2*m2)` with the operators of result_wrapper
+void BM_binder_eager(benchmark::State& state) {
+    aa::accumulator_set mset;
+    fill(mset, state.range(0));
+    const aa::result_set results(mset);
+    const aa::result_wrapper& m2=results["m2"];
+    const aa::result_wrapper& m4=results["m4"];
+    for (auto _ : state) {
+        aa::result_wrapper binder=1-m4/(3*m2*m2);
+        benchmark::DoNotOptimize(binder.error<double>());
+    }
+}
+
+/// Each iteration evaluates `1-m4/(3*m2*m2)` as a deferred expression
+void BM_binder_lazy(benchmark::State& state) {
+    aa::accumulator_set mset;
+    fill(mset, state.range(0));
+    const aa::result_set results(mset);
+    const aa::result_wrapper& m2=results["m2"];
+    const aa::result_wrapper& m4=results["m4"];
+    for (auto _ : state) {
+        aa::result_wrapper binder=1-aa::lazy(m4)/(3*aa::lazy(m2)*aa::lazy(m2));
+        benchmark::DoNotOptimize(binder.error<double>());
+    }
+}
+
+BENCHMARK(BM_binder_eager)->RangeMultiplier(8)->Range(128, 8192);
+BENCHMARK(BM_binder_lazy)->RangeMultiplier(8)->Range(128, 8192);
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file save_load_merge.cpp
+    Time to save, load and merge an accumulator set, and to look up its accumulators by name
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const std::size_t nobservables=20;
+
+    std::string name(std::size_t i) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "Observable_%04lu", static_cast<unsigned long>(i));
+        return buf;
+    }
+
+    /// A set of `nobservables` full binning accumulators of vectors of `nelements` elements, with `nsamples` samples each
+    void fill_set(aa::accumulator_set& mset, std::size_t nelements, int nsamples) {
+        for (std::size_t k=0; k<nobservables; ++k)
+            mset << aa::FullBinningAccumulator< std::vector<double> >(name(k));
+        std::vector<double> v(nelements);
+        for (int i=0; i<nsamples; ++i) {
+            for (std::size_t j=0; j<nelements; ++j) v[j]=std::sin(0.37*i+j);
+            for (std::size_t k=0; k<nobservables; ++k) mset[name(k)] << v;
+        }
+    }
+}
+
+/// Each iteration saves the set to a new file
+void BM_save(benchmark::State& state) {
+    aa::accumulator_set mset;
+    fill_set(mset, state.range(0), 1000);
+    alps::testing::unique_file ufile("bench_save.h5.", alps::testing::unique_file::REMOVE_AFTER);
+
+    for (auto _ : state) {
+        alps::hdf5::archive ar(ufile.name(), "w");
+        ar["measurements"] << mset;
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+/// Each iteration saves the set again to the same file, after adding one sample to one accumulator
+void BM_save_incremental(benchmark::State& state) {
+    aa::accumulator_set mset;
+    fill_set(mset, state.range(0), 1000);
+    alps::testing::unique_file ufile("bench_save.h5.", alps::testing::unique_file::REMOVE_AFTER);
+    const std::vector<double> v(state.range(0), 0.5);
+
+    for (auto _ : state) {
+        mset[name(0)] << v;
+        alps::hdf5::archive ar(ufile.name(), "a");
+        ar["measurements"] << mset;
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+/// Each iteration loads the set from a file
+void BM_load(benchmark::State& state) {
+    alps::testing::unique_file ufile("bench_load.h5.", alps::testing::unique_file::REMOVE_AFTER);
+    {
+        aa::accumulator_set mset;
+        fill_set(mset, state.range(0), 1000);
+        alps::hdf5::archive ar(ufile.name(), "w");
+        ar["measurements"] << mset;
+    }
+
+    for (auto _ : state) {
+        aa::accumulator_set mset;
+        alps::hdf5::archive ar(ufile.name(), "r");
+        ar["measurements"] >> mset;
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+/// Each iteration merges a set into a copy of another
+void BM_merge(benchmark::State& state) {
+    aa::accumulator_set lhs, rhs;
+    fill_set(lhs, state.range(0), 1000);
+    fill_set(rhs, state.range(0), 3000);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        aa::accumulator_set target;
+        for (aa::accumulator_set::const_iterator it=lhs.begin(); it!=lhs.end(); ++it)
+            target.insert(it->first, boost::shared_ptr<aa::accumulator_wrapper>(it->second->new_clone()));
+        state.ResumeTiming();
+        target.merge(rhs);
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+/// Each iteration looks up every accumulator of the set by name
+void BM_lookup(benchmark::State& state) {
+    aa::accumulator_set mset;
+    fill_set(mset, 1, 0);
+    std::vector<std::string> names;
+    for (std::size_t k=0; k<nobservables; ++k) names.push_back(name(k));
+
+    for (auto _ : state) {
+        for (std::size_t k=0; k<names.size(); ++k)
+            benchmark::DoNotOptimize(&mset[names[k]]);
+    }
+    state.SetItemsProcessed(state.iterations()*nobservables);
+}
+
+BENCHMARK(BM_save)->RangeMultiplier(16)->Range(1, 4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_save_incremental)->RangeMultiplier(16)->Range(1, 4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_load)->RangeMultiplier(16)->Range(1, 4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_merge)->RangeMultiplier(16)->Range(1, 4096)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_lookup);
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file set_access.cpp
+    Cost per measurement when adding to an accumulator set by name, by handle and to a static set
+*/
+
+#include <alps/accumulators.hpp>
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    std::vector<std::string> make_names(std::size_t n) {
+        std::vector<std::string> names(n);
+        char buf[32];
+        for (std::size_t i=0; i<n; ++i) {
+            std::snprintf(buf, sizeof(buf), "Observable_%04lu", static_cast<unsigned long>(i));
+            names[i]=buf;
+        }
+        return names;
+    }
+
+    template <typename A>
+    void fill_set(aa::accumulator_set& mset, std::vector<std::string> const& names) {
+        for (std::size_t i=0; i<names.size(); ++i) mset << A(names[i]);
+    }
+}
+
+/// Each iteration adds one value to every observable in the set, looking it up by name
+template <typename A>
+void BM_add_by_name(benchmark::State& state) {
+    const std::vector<std::string> names=make_names(state.range(0));
+    aa::accumulator_set mset;
+    fill_set<A>(mset, names);
+
+    double x=0.5;
+    for (auto _ : state) {
+        for (std::size_t i=0; i<names.size(); ++i) mset[names[i]] << x;
+        x+=0.25;
+    }
+    state.SetItemsProcessed(state.iterations()*names.size());
+}
+
+/// Each iteration adds one value to every observable in the set via handles
+template <typename A>
+void BM_add_by_handle(benchmark::State& state) {
+    const std::vector<std::string> names=make_names(state.range(0));
+    aa::accumulator_set mset;
+    fill_set<A>(mset, names);
+    std::vector< aa::accumulator_handle<A> > handles;
+    for (std::size_t i=0; i<names.size(); ++i) handles.push_back(mset.template handle<A>(names[i]));
+
+    double x=0.5;
+    for (auto _ : state) {
+        for (std::size_t i=0; i<handles.size(); ++i) handles[i] << x;
+        x+=0.25;
+    }
+    state.SetItemsProcessed(state.iterations()*handles.size());
+}
+
+/// Each iteration adds one value to each of three observables of a statically typed set
+template <typename A>
+void BM_add_static(benchmark::State& state) {
+    aa::static_accumulator_set<A, A, A> sset(A("a"), A("b"), A("c"));
+
+    double x=0.5;
+    for (auto _ : state) {
+        sset.template get<0>()(x);
+        sset.template get<1>()(x);
+        sset.template get<2>()(x);
+        x+=0.25;
+    }
+    state.SetItemsProcessed(state.iterations()*3);
+}
+
+/// Same as BM_add_static, through handles into a dynamic set
+template <typename A>
+void BM_add_static_by_handle(benchmark::State& state) {
+    aa::accumulator_set mset;
+    mset << A("a") << A("b") << A("c");
+    aa::accumulator_handle<A> a=mset.template handle<A>("a"), b=mset.template handle<A>("b"), c=mset.template handle<A>("c");
+
+    double x=0.5;
+    for (auto _ : state) {
+        a << x;
+        b << x;
+        c << x;
+        x+=0.25;
+    }
+    state.SetItemsProcessed(state.iterations()*3);
+}
+
+BENCHMARK_TEMPLATE(BM_add_by_name, aa::MeanAccumulator<double>)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK_TEMPLATE(BM_add_by_handle, aa::MeanAccumulator<double>)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK_TEMPLATE(BM_add_by_name, aa::FullBinningAccumulator<double>)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK_TEMPLATE(BM_add_by_handle, aa::FullBinningAccumulator<double>)->RangeMultiplier(10)->Range(10, 1000);
+BENCHMARK_TEMPLATE(BM_add_static, aa::MeanAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_static_by_handle, aa::MeanAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_static, aa::FullBinningAccumulator<double>);
+BENCHMARK_TEMPLATE(BM_add_static_by_handle, aa::FullBinningAccumulator<double>);
@@ -9,5 +9,10 @@
 
 #include <alps/accumulators/accumulator.hpp>
 #include <alps/accumulators/namedaccumulators.hpp>
+#include <alps/accumulators/accumulator_handle.hpp>
+#include <alps/accumulators/sharded_accumulator_set.hpp>
+#include <alps/accumulators/static_accumulator_set.hpp>
+#include <alps/accumulators/ratio_accumulator_set.hpp>
+#include <alps/accumulators/result_expression.hpp>
 
 #endif
@@ -13,6 +13,8 @@
 #include <alps/accumulators/wrappers.hpp>
 // #include <alps/accumulators/feature/weight_holder.hpp>
 #include <alps/accumulators/wrapper_set.hpp>
+#include <alps/accumulators/sample_adapter.hpp>
+#include <alps/accumulators/computed.hpp>
 
 #include <alps/hdf5/archive.hpp>
 
@@ -208,6 +210,11 @@ namespace alps {
                     return boost::apply_visitor(visitor, m_variant);
                 }
 
+                /// Results are not tracked: the stamp is new on every call, so they are always saved
+                boost::uint64_t modification_stamp() const {
+                    return detail::next_modification_stamp();
+                }
+
             // mean, error
             #define ALPS_ACCUMULATOR_PROPERTY_PROXY(PROPERTY, TYPE)                                                 \
                 private:                                                                                            \
@@ -576,6 +583,7 @@ namespace alps {
             /// default constructor
                 accumulator_wrapper()
                     : m_variant()
+                    , m_stamp(detail::next_modification_stamp())
                 {}
 
             /// constructor from raw accumulator
@@ -583,16 +591,20 @@ namespace alps {
                     : m_variant(typename detail::add_base_wrapper_pointer<typename value_type<T>::type>::type(
                         new derived_accumulator_wrapper<T>(arg))
                       )
+                    , m_stamp(detail::next_modification_stamp())
                 {}
 
             /// copy constructor
             /// @note The wrapped accumulator object is NOT copied!
                 accumulator_wrapper(accumulator_wrapper const & rhs)
                     : m_variant(rhs.m_variant)
+                    , m_stamp(detail::next_modification_stamp())
                 {}
 
             // constructor from hdf5
-                accumulator_wrapper(hdf5::archive & ar) {
+                accumulator_wrapper(hdf5::archive & ar)
+                    : m_stamp(detail::next_modification_stamp())
+                {
                     ar[""] >> *this;
                 }
 
@@ -616,16 +628,86 @@ namespace alps {
                     }
                     T const & value;
                 };
+                template<typename S> struct call_computed_visitor: public boost::static_visitor<> {
+                    call_computed_visitor(computed<S> const & v) : value(v) {}
+                    template<typename X> void apply(typename boost::enable_if<
+                        typename boost::is_same<S, typename detail::computed_element<typename value_type<X>::type>::type>::type, X &
+                    >::type arg) const {
+                        arg.add_computed(value);
+                    }
+                    template<typename X> void apply(typename boost::disable_if<
+                        typename boost::is_same<S, typename detail::computed_element<typename value_type<X>::type>::type>::type, X &
+                    >::type /*arg*/) const {
+                        throw std::logic_error(std::string("cannot add a computed sample of ") + typeid(S).name() + " to an accumulator of " + typeid(typename value_type<X>::type).name() + ALPS_STACKTRACE);
+                    }
+                    template<typename X> void operator()(X & arg) const {
+                        check_ptr(arg);
+                        apply<typename X::element_type>(*arg);
+                    }
+                    computed<S> const & value;
+                };
+
+                template<typename T> void add_sample(T const & value, boost::false_type) {
+                    typedef detail::sample_adapter<T> adapter;
+                    typename adapter::type const & sample = adapter::convert(value);
+                    check_nonempty_vector(sample);
+                    boost::apply_visitor(call_1_visitor<typename adapter::type>(sample), m_variant);
+                }
+
+                template<typename T> void add_sample(T const & value, boost::true_type) {
+                    if (!value.size())
+                        throw std::runtime_error("Zero-sized vector observables are not allowed");
+                    boost::apply_visitor(call_computed_visitor<typename T::value_type>(value), m_variant);
+                }
             public:
+                /// Add the sample `value`
+                /** Samples of other vector types are converted by `detail::sample_adapter`:
+                    e.g., an Eigen dense vector or array (or an expression of them) is added
+                    to an accumulator of `std::vector` of the same scalar type. It is copied
+                    into a reused buffer rather than into a new `std::vector` per sample.
+                    A `computed` sample adds itself to the accumulator (see `computed`). */
                 template<typename T> void operator()(T const & value) {
-                    check_nonempty_vector(value);
-                    boost::apply_visitor(call_1_visitor<T>(value), m_variant);
+                    add_sample(value, typename detail::is_computed<T>::type());
                 }
                 template<typename T> accumulator_wrapper & operator<<(T const & value) {
                     (*this)(value);
                     return (*this);
                 }
 
+            // add_range(T const *, T const *)
+            private:
+                template<typename T> struct add_range_visitor: public boost::static_visitor<> {
+                    add_range_visitor(T const * f, T const * l) : first(f), last(l) {}
+                    template<typename X> void apply(typename boost::enable_if<
+                        typename boost::is_same<T, typename value_type<X>::type>::type, X &
+                    >::type arg) const {
+                        arg.add_range(first, last);
+                    }
+                    template<typename X> void apply(typename boost::disable_if<
+                        typename boost::is_same<T, typename value_type<X>::type>::type, X &
+                    >::type /*arg*/) const {
+                        throw std::logic_error(std::string("cannot add a range of ") + typeid(T).name() + " to an accumulator of " + typeid(typename value_type<X>::type).name() + ALPS_STACKTRACE);
+                    }
+                    template<typename X> void operator()(X & arg) const {
+                        check_ptr(arg);
+                        apply<typename X::element_type>(*arg);
+                    }
+                    T const * first;
+                    T const * last;
+                };
+            public:
+                /// Add the contiguous range of samples [first, last)
+                /** The result is the same as adding the samples one by one, but the
+                    accumulator is dispatched to once per range. The binning analysis still
+                    does its work per sample and per level; it is only reordered to go
+                    level by level over the range. The element type must match the value
+                    type of the accumulator exactly. */
+                template<typename T> void add_range(T const * first, T const * last) {
+                    for (T const * it = first; it != last; ++it)
+                        check_nonempty_vector(*it);
+                    boost::apply_visitor(add_range_visitor<T>(first, last), m_variant);
+                }
+
                 // Code to merge accumulators
             private:
                 /// Service class to access elements of a variant type
@@ -652,6 +734,7 @@ namespace alps {
                 void merge(const accumulator_wrapper& rhs_acc) {
                   merge_visitor visitor(rhs_acc);
                   boost::apply_visitor(visitor, m_variant);
+                  touch();
                 }
 
             // // operator(T, W)
@@ -727,6 +810,7 @@ namespace alps {
             public:
                 accumulator_wrapper & operator=(boost::shared_ptr<accumulator_wrapper> const & rhs) {
                     boost::apply_visitor(assign_visitor(this), rhs->m_variant);
+                    touch();
                     return *this;
                 }
 
@@ -740,10 +824,12 @@ namespace alps {
                     typename detail::add_base_wrapper_pointer<T>::type value;
                 };
             public:
+                /// The wrapped accumulator; it counts as modified, see `modification_stamp()`
                 template <typename T> base_wrapper<T> & get() {
                     get_visitor<T> visitor;
                     boost::apply_visitor(visitor, m_variant);
                     check_ptr(visitor.value);
+                    touch();
                     return *visitor.value;
                 }
 
@@ -753,8 +839,10 @@ namespace alps {
                     template<typename T> A* operator()(T const & arg) { check_ptr(arg);  return &arg->template extract<A>(); }
                 };
             public:
+                /// The wrapped accumulator; it counts as modified, see `modification_stamp()`
                 template <typename A> A & extract() {
                     extract_visitor<A> visitor;
+                    touch();
                     return *boost::apply_visitor(visitor, m_variant);
                 }
 
@@ -769,6 +857,28 @@ namespace alps {
                     return boost::apply_visitor(visitor, m_variant);
                 }
 
+                /// Changes whenever the accumulator is modified other than by adding samples
+                /** Adding samples changes the count instead; together, they tell whether
+                    the accumulator changed since it was last saved (see `wrapper_set::save`). */
+                boost::uint64_t modification_stamp() const {
+                    return m_stamp;
+                }
+
+            // reached_precision
+            private:
+                struct reached_precision_visitor: public boost::static_visitor<bool> {
+                    reached_precision_visitor(double r): relative_error(r) {}
+                    template<typename T> bool operator()(T const & arg) const { check_ptr(arg); return arg->reached_precision(relative_error); }
+                    double relative_error;
+                };
+            public:
+                /// Whether the error bar has converged to at most `relative_error` times the mean, for every element
+                /** Cheap enough to poll after every sweep (see `impl::Accumulator<T, binning_analysis_tag, B>::reached_precision()`);
+                    throws for the accumulators without binning analysis. */
+                bool reached_precision(double relative_error) const {
+                    return boost::apply_visitor(reached_precision_visitor(relative_error), m_variant);
+                }
+
             // mean, error
             #define ALPS_ACCUMULATOR_PROPERTY_PROXY(PROPERTY, TYPE)                                                 \
                 private:                                                                                            \
@@ -821,6 +931,7 @@ namespace alps {
             public:
                 void load(hdf5::archive & ar) {
                     boost::apply_visitor(load_visitor(ar), m_variant);
+                    touch();
                 }
 
             // reset
@@ -831,6 +942,7 @@ namespace alps {
             public:
                 void reset() const {
                     boost::apply_visitor(reset_visitor(), m_variant);
+                    touch();
                 }
 
             // result
@@ -875,15 +987,53 @@ namespace alps {
             public:
                 inline void collective_merge(alps::mpi::communicator const & comm, int root) {
                     boost::apply_visitor(collective_merge_visitor(comm, root), m_variant);
+                    touch();
                 }
                 inline void collective_merge(alps::mpi::communicator const & comm, int root) const {
                     boost::apply_visitor(collective_merge_visitor(comm, root), m_variant);
                 }
+
+            // packed merge, see alps::alps_mpi::packed_reduction
+            private:
+                enum pack_step { pack_shape_pass, pack_gather_pass, pack_pass, unpack_pass };
+                struct pack_visitor: public boost::static_visitor<> {
+                    pack_visitor(alps::alps_mpi::packed_reduction & b, pack_step p): buffer(b), pass(p) {}
+                    template<typename T> void operator()(T const & arg) const {
+                        check_ptr(arg);
+                        switch (pass) {
+                            case pack_shape_pass: arg->pack_shape(buffer); break;
+                            case pack_gather_pass: arg->pack_gather(buffer); break;
+                            case pack_pass: arg->pack(buffer); break;
+                            case unpack_pass: arg->unpack(buffer); break;
+                        }
+                    }
+                    alps::alps_mpi::packed_reduction & buffer;
+                    pack_step pass;
+                };
+            public:
+                void pack_shape(alps::alps_mpi::packed_reduction & buffer) const {
+                    boost::apply_visitor(pack_visitor(buffer, pack_shape_pass), m_variant);
+                }
+                void pack_gather(alps::alps_mpi::packed_reduction & buffer) const {
+                    boost::apply_visitor(pack_visitor(buffer, pack_gather_pass), m_variant);
+                }
+                void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                    boost::apply_visitor(pack_visitor(buffer, pack_pass), m_variant);
+                }
+                void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                    boost::apply_visitor(pack_visitor(buffer, unpack_pass), m_variant);
+                    touch();
+                }
 #endif
 
             private:
 
+                void touch() const {
+                    m_stamp = detail::next_modification_stamp();
+                }
+
                 detail::variant_type m_variant;
+                mutable boost::uint64_t m_stamp;
         };
 
         inline std::ostream & operator<<(std::ostream & os, const accumulator_wrapper & arg) {
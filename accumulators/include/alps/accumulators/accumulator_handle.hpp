@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file accumulator_handle.hpp defines handles to accumulators held in an accumulator_set */
+
+#ifndef ALPS_ACCUMULATOR_ACCUMULATOR_HANDLE_HPP
+#define ALPS_ACCUMULATOR_ACCUMULATOR_HANDLE_HPP
+
+#include <alps/config.hpp>
+#include <alps/accumulators/accumulator.hpp>
+
+#include <vector>
+#include <stdexcept>
+
+namespace alps {
+    namespace accumulators {
+
+        /// Handle to an accumulator of the named accumulator type A (e.g. `FullBinningAccumulator<double>`)
+        /** The handle is obtained once, e.g. in the constructor of the simulation,
+            by `accumulator_set::handle<A>(name)`. Adding a value through the handle
+            calls the accumulator directly, without a name lookup in the set, without
+            the variant visitation and without a virtual call.
+
+            The handle shares the ownership of the accumulator with the set. It keeps
+            referring to the same accumulator after `reset()` and `merge()`, but not
+            after the set is loaded from an archive (loading replaces the accumulators).
+
+            Example:
+            @code
+                accumulator_set measurements;
+                measurements << FullBinningAccumulator<double>("Energy");
+                accumulator_handle< FullBinningAccumulator<double> > energy
+                    = measurements.handle< FullBinningAccumulator<double> >("Energy");
+                energy << -0.5;
+            @endcode
+        */
+        template<typename A> class accumulator_handle {
+            public:
+                typedef typename A::accumulator_type accumulator_type;
+                typedef typename value_type<accumulator_type>::type value_type;
+
+                /// Constructs an empty handle; it must be assigned before use
+                accumulator_handle()
+                    : m_wrapper()
+                    , m_acc(NULL)
+                {}
+
+                /// Constructs the handle to the accumulator held by the wrapper
+                /** @throws std::bad_cast if the wrapped accumulator is not of type A */
+                explicit accumulator_handle(accumulator_wrapper const & wrapper)
+                    : m_wrapper(wrapper)
+                    , m_acc(&m_wrapper.extract<accumulator_type>())
+                {}
+
+                void operator()(value_type const & value) {
+                    check_nonempty_vector(value);
+                    (*m_acc)(value);
+                }
+
+                accumulator_handle & operator<<(value_type const & value) {
+                    (*this)(value);
+                    return *this;
+                }
+
+                /// Add a sample of another type, converted by `detail::sample_adapter` (e.g., an Eigen vector), or a `computed` sample
+                template<typename T> accumulator_handle & operator<<(T const & value) {
+                    add_sample(value, typename detail::is_computed<T>::type());
+                    return *this;
+                }
+
+                /// Add the contiguous range of samples [first, last); see `accumulator_wrapper::add_range()`
+                void add_range(value_type const * first, value_type const * last) {
+                    for (value_type const * it = first; it != last; ++it)
+                        check_nonempty_vector(*it);
+                    m_acc->add_range(first, last);
+                }
+
+                /// Returns the underlying raw accumulator
+                accumulator_type & extract() {
+                    return *m_acc;
+                }
+                accumulator_type const & extract() const {
+                    return *m_acc;
+                }
+
+                /// Returns the wrapper (sharing the accumulator with the set)
+                accumulator_wrapper const & wrapper() const {
+                    return m_wrapper;
+                }
+
+            private:
+                template <typename T>
+                static void check_nonempty_vector(const T&) {}
+
+                template <typename T>
+                static void check_nonempty_vector(const std::vector<T>& vec) {
+                    if (vec.empty()) throw std::runtime_error("Zero-sized vector observables are not allowed");
+                }
+
+                template<typename T> void add_sample(T const & value, boost::false_type) {
+                    (*this)(detail::sample_adapter<T>::convert(value));
+                }
+
+                template<typename T> void add_sample(T const & value, boost::true_type) {
+                    if (!value.size())
+                        throw std::runtime_error("Zero-sized vector observables are not allowed");
+                    detail::add_computed(*m_acc, value);
+                }
+
+                accumulator_wrapper m_wrapper;
+                accumulator_type * m_acc;
+        };
+
+    }
+}
+
+ #endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file bin_slab.hpp
+    @brief Contiguous storage of the bins of vector-valued binning accumulators
+*/
+
+#ifndef ALPS_ACCUMULATOR_BIN_SLAB_HPP
+#define ALPS_ACCUMULATOR_BIN_SLAB_HPP
+
+#include <alps/config.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace alps {
+    namespace accumulators {
+        namespace detail {
+
+            /// Bins stored as the rows of one contiguous slab; only bins of type `std::vector` of arithmetic type have one
+            /** This primary template stands in for the other bin types and holds no bins. */
+            template<typename M, typename Enable = void> class bin_slab {
+              public:
+                static const bool enabled = false;
+
+                std::size_t rows() const { return 0; }
+                std::size_t row_size() const { return 0; }
+                M const * row(std::size_t) const { return 0; }
+                void clear() {}
+                void assign(std::vector<M> const &, std::size_t) {}
+                void copy_to(std::vector<M> &, std::size_t) const {}
+            };
+
+            /// Bins of type `std::vector<T>`, stored as the rows of one slab of `max_number` times the bin size
+            /** The slab is allocated when the first bin is added, so that adding bins and
+                halving their number never allocate; halving averages pairs of rows into the
+                front rows in place. The rows have the layout of the dataset `timeseries/data`. */
+            template<typename T> class bin_slab<std::vector<T>, typename boost::enable_if<boost::is_arithmetic<T> >::type> {
+              public:
+                static const bool enabled = true;
+
+                bin_slab()
+                    : m_size(0)
+                    , m_rows(0)
+                {}
+
+                std::size_t rows() const { return m_rows; }
+                std::size_t row_size() const { return m_size; }
+
+                T * row(std::size_t i) { return m_data.empty() ? 0 : &m_data[0] + i * m_size; }
+                T const * row(std::size_t i) const { return m_data.empty() ? 0 : &m_data[0] + i * m_size; }
+
+                /// Drops the rows; the storage is kept
+                void clear() {
+                    m_rows = 0;
+                }
+
+                /// Copies the bins `bins` into the slab, which is sized for (at least) `max_number` bins
+                void assign(std::vector<std::vector<T> > const & bins, std::size_t max_number) {
+                    m_rows = 0;
+                    if (bins.empty())
+                        return;
+                    reserve(bins[0].size(), std::max(bins.size(), max_number));
+                    for (std::size_t i = 0; i < bins.size(); ++i)
+                        push_back(bins[i].empty() ? 0 : &bins[i][0], bins[i].size(), T(1));
+                }
+
+                /// Appends the bin `value / divisor`, where `value` has `size` elements
+                /** The slab is allocated for `max_number` bins of `size` elements if it holds none. */
+                void push_back(T const * value, std::size_t size, T const & divisor, std::size_t max_number = 1) {
+                    if (!m_rows)
+                        reserve(size, max_number);
+                    else if (size != m_size)
+                        throw std::runtime_error("vectors must have the same size!" + ALPS_STACKTRACE);
+                    if ((m_rows + 1) * m_size > m_data.size())
+                        m_data.resize((m_rows + 1) * m_size);
+                    T * d = row(m_rows);
+                    for (std::size_t k = 0; k < m_size; ++k)
+                        d[k] = value[k] / divisor;
+                    ++m_rows;
+                }
+
+                /// Replaces the first `pairs` pairs of rows by their averages, `(x + y) / two`, and drops the other rows
+                void halve(std::size_t pairs, T const & two) {
+                    for (std::size_t i = 0; i < pairs; ++i) {
+                        T * d = row(i);
+                        T const * x = row(2 * i);
+                        T const * y = row(2 * i + 1);
+                        for (std::size_t k = 0; k < m_size; ++k)
+                            d[k] = (x[k] + y[k]) / two;
+                    }
+                    m_rows = pairs;
+                }
+
+                /// Copies the rows from `first` on into `bins`, which is resized to the number of rows
+                /** The storage of the elements of `bins` is reused. */
+                void copy_to(std::vector<std::vector<T> > & bins, std::size_t first) const {
+                    bins.resize(m_rows);
+                    for (std::size_t i = first; i < m_rows; ++i)
+                        bins[i].assign(row(i), row(i) + m_size);
+                }
+
+              private:
+
+                void reserve(std::size_t size, std::size_t max_number) {
+                    m_size = size;
+                    if (m_data.size() < max_number * size)
+                        m_data.resize(max_number * size);
+                }
+
+                std::size_t m_size, m_rows;
+                std::vector<T> m_data;
+            };
+
+        }
+    }
+}
+
+#endif
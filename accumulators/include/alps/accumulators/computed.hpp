@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file computed.hpp
+    @brief Samples which are computed in place, by adding themselves to a buffer of the accumulator
+*/
+
+#ifndef ALPS_ACCUMULATOR_COMPUTED_HPP
+#define ALPS_ACCUMULATOR_COMPUTED_HPP
+
+#include <alps/config.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#include <boost/type_traits/is_base_of.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace alps {
+    namespace accumulators {
+
+        namespace detail {
+            struct computed_base {};
+        }
+
+        /// A sample which is computed on the fly (cf. `alps::alea::computed`)
+        /** Instead of being materialized as a value, the sample adds itself to a buffer
+            of the accumulator: an estimator which is naturally a sum, or sparse, writes
+            only what it contributes. As an example, a vector sample with a single
+            nonzero element:
+
+                struct delta : public alps::accumulators::computed<double> {
+                    std::size_t n, i;
+                    std::size_t size() const { return n; }
+                    void add_to(double * out) const { out[i] += 1; }
+                };
+
+            A `computed<S>` is added to accumulators of `std::vector<S>`, or of `S` if
+            its size is 1. Accumulators which only have a mean (`MeanAccumulator`) add it
+            directly to their sum; the others need the sample itself for its square and
+            its bins, and evaluate it into a buffer which is reused from sample to sample.
+        */
+        template<typename S> struct computed : public detail::computed_base {
+            typedef S value_type;
+
+            virtual ~computed() {}
+
+            /// Number of elements of the sample
+            virtual std::size_t size() const = 0;
+
+            /// Add the sample to the `size()` elements of `out`: `out[i] += sample[i]`
+            virtual void add_to(S * out) const = 0;
+        };
+
+        namespace detail {
+
+            /// Whether `T` is a computed sample
+            template<typename T> struct is_computed : public boost::is_base_of<computed_base, T> {};
+
+            /// Type of the elements of the computed samples which are added to accumulators of `T`
+            template<typename T> struct computed_element {
+                typedef T type;
+            };
+            template<typename T> struct computed_element<std::vector<T> > {
+                typedef T type;
+            };
+
+            /// Add `src` to `acc`, which is sized like `src` if it is empty
+            template<typename T> void add_computed_to(T & acc, computed<T> const & src) {
+                if (src.size() != 1)
+                    throw std::runtime_error("a computed sample of size 1 is needed for a scalar accumulator" + ALPS_STACKTRACE);
+                src.add_to(&acc);
+            }
+            template<typename T> void add_computed_to(std::vector<T> & acc, computed<T> const & src) {
+                if (acc.empty())
+                    acc.assign(src.size(), T());
+                else if (acc.size() != src.size())
+                    throw std::runtime_error("vectors must have the same size!" + ALPS_STACKTRACE);
+                if (!acc.empty())
+                    src.add_to(&acc[0]);
+            }
+
+            /// Evaluate `src` into `value`; the storage of `value` is reused
+            template<typename T> void evaluate_computed(T & value, computed<T> const & src) {
+                value = T();
+                add_computed_to(value, src);
+            }
+            template<typename T> void evaluate_computed(std::vector<T> & value, computed<T> const & src) {
+                value.assign(src.size(), T());
+                if (!value.empty())
+                    src.add_to(&value[0]);
+            }
+
+        }
+    }
+}
+
+#endif // ALPS_ACCUMULATOR_COMPUTED_HPP
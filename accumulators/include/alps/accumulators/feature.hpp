@@ -95,6 +95,20 @@ namespace alps {
                 ) const {
                     throw std::logic_error("A result cannot be merged " + ALPS_STACKTRACE);
                 }
+
+                /// Dummy functions for the packed merge of results (always throw an exception)
+                void pack_shape(alps::alps_mpi::packed_reduction &) const {
+                    throw std::logic_error("A result cannot be merged " + ALPS_STACKTRACE);
+                }
+                void pack_gather(alps::alps_mpi::packed_reduction &) const {
+                    throw std::logic_error("A result cannot be merged " + ALPS_STACKTRACE);
+                }
+                void pack(alps::alps_mpi::packed_reduction &) const {
+                    throw std::logic_error("A result cannot be merged " + ALPS_STACKTRACE);
+                }
+                void unpack(alps::alps_mpi::packed_reduction &) {
+                    throw std::logic_error("A result cannot be merged " + ALPS_STACKTRACE);
+                }
 #endif
 
                 template<typename U> void operator+=(U const &) {}
@@ -164,6 +178,12 @@ namespace alps {
                     void log() { throw std::runtime_error("The Function log is not implemented for accumulators, only for results" + ALPS_STACKTRACE); }
 
 #ifdef ALPS_HAVE_MPI
+                    /// The passes of the packed merge of many accumulators, see `alps::alps_mpi::packed_reduction`
+                    void pack_shape(alps::alps_mpi::packed_reduction &) const {}
+                    void pack_gather(alps::alps_mpi::packed_reduction &) const {}
+                    void pack(alps::alps_mpi::packed_reduction &) const {}
+                    void unpack(alps::alps_mpi::packed_reduction &) {}
+
                 protected:
                     template <typename U, typename Op> void static reduce_if(
                           alps::mpi::communicator const & comm
@@ -22,6 +22,7 @@
 #include <alps/numeric/inf.hpp>
 #include <alps/numeric/check_size.hpp>
 #include <alps/numeric/vector_functions.hpp>
+#include <alps/accumulators/inplace_eigen.hpp>
 #include <alps/numeric/boost_array_functions.hpp>
 #include <alps/numeric/set_negative_0.hpp>
 #include <alps/numeric/rectangularize.hpp>
@@ -105,6 +106,21 @@ namespace alps {
                 throw std::runtime_error(std::string(typeid(A).name()) + " has no autocorrelation-method" + ALPS_STACKTRACE);
                 return *static_cast<typename autocorrelation_type<A>::type *>(NULL);
             }
+
+            template<typename A> typename boost::enable_if<
+                  typename has_feature<A, binning_analysis_tag>::type
+                , bool
+            >::type reached_precision_impl(A const & acc, double relative_error) {
+                return acc.reached_precision(relative_error);
+            }
+
+            template<typename A> typename boost::disable_if<
+                  typename has_feature<A, binning_analysis_tag>::type
+                , bool
+            >::type reached_precision_impl(A const & /*acc*/, double /*relative_error*/) {
+                throw std::runtime_error(std::string(typeid(A).name()) + " has no binning analysis to tell its convergence" + ALPS_STACKTRACE);
+                return false;
+            }
         }
 
         namespace impl {
@@ -120,6 +136,7 @@ namespace alps {
                         , m_ac_sum2()
                         , m_ac_partial()
                         , m_ac_count()
+                        , m_cache()
                     {}
 
                     Accumulator(Accumulator const & arg)
@@ -128,6 +145,7 @@ namespace alps {
                         , m_ac_sum2(arg.m_ac_sum2)
                         , m_ac_partial(arg.m_ac_partial)
                         , m_ac_count(arg.m_ac_count)
+                        , m_cache(arg.m_cache)
                     {}
 
                     template<typename ArgumentPack> Accumulator(ArgumentPack const & args, typename boost::disable_if<is_accumulator<ArgumentPack>, int>::type = 0)
@@ -136,9 +154,13 @@ namespace alps {
                         , m_ac_sum2()
                         , m_ac_partial()
                         , m_ac_count()
+                        , m_cache()
                     {}                    
 
                     typename alps::accumulators::convergence_type<B>::type converged_errors() const {
+                        using alps::numeric::operator*;
+                        using alps::numeric::operator+;
+                        using alps::numeric::check_size;
                         typedef typename alps::numeric::scalar<typename convergence_type<T>::type>::type convergence_scalar_type;
 
                         typename alps::accumulators::convergence_type<B>::type conv;
@@ -153,7 +175,7 @@ namespace alps {
                             // TODO: how to we iterate over the datatype?
                             for (unsigned int i = depth - range; i < depth - 1; ++i) {
                                 typename slice_index<typename alps::accumulators::convergence_type<B>::type>::type it;
-                                result_type this_err(error(i));
+                                typename alps::accumulators::error_type<B>::type this_err(error(i));
                                 for (it = slices(conv).first; it != slices(conv).second; ++it)
                                     if (std::abs(slice_value(this_err, it)) >= std::abs(slice_value(err,it)))
                                         slice_value(conv,it) = CONVERGED;
@@ -248,10 +270,52 @@ namespace alps {
                         return m_ac_sum2.size() < 8 ? 1 : m_ac_sum2.size() - 7;
                     }
 
+                    /// The error bar, as `error()`, recomputed only when a bin closes at the binning levels it depends on
+                    /** The error, its convergence and the autocorrelation time depend on the
+                        bins of the few largest binning levels; they are cached together and recomputed
+                        when a bin closes at the lowest of these levels, i.e. once every
+                        `count()/1024` samples or so. The cached error and convergence are the same
+                        as `error()` and `converged_errors()`; the cached autocorrelation (and the mean
+                        used by `reached_precision()`) may lag behind by the samples since then.
+                        These queries are for polling a running simulation, e.g. by
+                        `alps::convergence_callback`; they must not be called concurrently. */
+                    typename alps::accumulators::error_type<B>::type const & cached_error() const {
+                        update_cache();
+                        return m_cache.error;
+                    }
+
+                    /// The autocorrelation time, as `autocorrelation()` when the cache was last updated (see `cached_error()`)
+                    typename autocorrelation_type<B>::type const & cached_autocorrelation() const {
+                        update_cache();
+                        return m_cache.autocorrelation;
+                    }
+
+                    /// The convergence of the error bar, as `converged_errors()` (see `cached_error()`)
+                    typename alps::accumulators::convergence_type<B>::type const & cached_converged_errors() const {
+                        update_cache();
+                        return m_cache.converged;
+                    }
+
+                    /// Whether the error bar of every element has converged and is at most `relative_error` times the magnitude of its mean
+                    /** Uses the cached values (see `cached_error()`); the convergence needs at
+                        least 1024 samples to be known. A mean of zero never reaches the precision. */
+                    bool reached_precision(double relative_error) const {
+                        using std::abs;
+                        using alps::numeric::abs;
+
+                        if (!B::count())
+                            return false;
+                        update_cache();
+                        typename slice_index<typename alps::accumulators::convergence_type<B>::type>::type it;
+                        for (it = slices(m_cache.converged).first; it != slices(m_cache.converged).second; ++it)
+                            if (slice_value(m_cache.converged, it) != CONVERGED
+                                || !(abs(slice_value(m_cache.error, it)) <= relative_error * abs(slice_value(m_cache.mean, it))))
+                                return false;
+                        return true;
+                    }
+
                     using B::operator();
                     void operator()(T const & val) {
-                        using alps::numeric::operator+=;
-                        using alps::numeric::operator*;
                         using alps::numeric::check_size;
 
                         B::operator()(val);
@@ -267,17 +331,49 @@ namespace alps {
                         BOOST_ASSERT_MSG(m_ac_partial.size() >= m_ac_sum2.size(), "m_ac_partial is as large as m_ac_sum2");
                         BOOST_ASSERT_MSG(m_ac_count.size() >= m_ac_sum2.size(), "m_ac_count is as large as m_ac_sum2");
                         BOOST_ASSERT_MSG(m_ac_sum.size() >= m_ac_sum2.size(), "m_ac_sum is as large as m_ac_sum2");
-                        for (unsigned i = 0; i < m_ac_sum2.size(); ++i) {
-                            m_ac_partial[i] += val;
-
-                            // in other words: (B::count() % (1L << i) == 0)
-                            if (!(B::count() & ((1ll << i) - 1))) {
-                                m_ac_sum2[i] += m_ac_partial[i] * m_ac_partial[i];
-                                m_ac_sum[i] += m_ac_partial[i];
-                                m_ac_count[i]++;
-                                m_ac_partial[i] = T();
-                                check_size(m_ac_partial[i], val);
-                            }                            
+                        for (unsigned i = 0; i < m_ac_sum2.size(); ++i)
+                            add_to_level(i, B::count(), val);
+                    }
+
+                    /// Add the samples in [first, last); the result is the same as adding them one by one
+                    /** The binning levels are extended once for the whole range, and then
+                        each level is updated in one pass over the range. */
+                    void add_range(T const * first, T const * last) {
+                        using alps::numeric::check_size;
+                        typedef typename count_type<B>::type count_t;
+
+                        if (first == last)
+                            return;
+                        const count_t count0 = B::count();
+                        const std::size_t n = last - first;
+                        B::add_range(first, last);
+
+                        const std::size_t old_depth = m_ac_sum2.size();
+                        while (B::count() >= (1UL << m_ac_sum2.size())) {
+                            m_ac_sum2.push_back(T());
+                            check_size(m_ac_sum2.back(), *first);
+                            m_ac_sum.push_back(T());
+                            check_size(m_ac_sum.back(), *first);
+                            m_ac_partial.push_back(T());
+                            m_ac_count.push_back(count_t());
+                        }
+
+                        // Level 0; a new level L is created when the count reaches 2^L,
+                        // and its partial bin starts from the level 0 sum at that point
+                        std::size_t next_level = old_depth;
+                        for (std::size_t k = 0; k < n; ++k) {
+                            const count_t cnt = count0 + k + 1;
+                            if (cnt == (1UL << next_level)) {
+                                m_ac_partial[next_level] = m_ac_sum[0];
+                                check_size(m_ac_partial[next_level], first[k]);
+                                ++next_level;
+                            }
+                            add_to_level(0, cnt, first[k]);
+                        }
+                        for (std::size_t i = 1; i < m_ac_sum2.size(); ++i) {
+                            const std::size_t k0 = (i < old_depth ? 0 : (1UL << i) - count0 - 1);
+                            for (std::size_t k = k0; k < n; ++k)
+                                add_to_level(i, count0 + k + 1, first[k]);
                         }
                     }
 
@@ -325,6 +421,7 @@ namespace alps {
                             ar["tau/ac_count"] >> m_ac_count; // FIXME: proper dataset name?
                         if (ar.is_data("tau/ac_partial"))
                             ar["tau/ac_partial"] >> m_ac_partial;  // FIXME: proper dataset name?
+                        invalidate_cache();
                     }
 
                     static std::size_t rank() { return B::rank() + 1; }
@@ -342,6 +439,7 @@ namespace alps {
                         m_ac_sum2 = std::vector<T>();
                         m_ac_partial = std::vector<T>();
                         m_ac_count = std::vector<typename count_type<B>::type>();
+                        invalidate_cache();
                     }
 
                     /// Merge the bins of the given accumulator of type A into this accumulator @param rhs Accumulator to merge
@@ -354,6 +452,7 @@ namespace alps {
                         merge(m_ac_count,rhs.m_ac_count);
                         merge(m_ac_sum,rhs.m_ac_sum);
                         merge(m_ac_sum2,rhs.m_ac_sum2);
+                        invalidate_cache();
                     }
 
 #ifdef ALPS_HAVE_MPI
@@ -377,6 +476,7 @@ namespace alps {
                             m_ac_sum2.resize(size);
                             alps::numeric::rectangularize(m_ac_sum2);
                             B::reduce_if(comm, std::vector<T>(m_ac_sum2), m_ac_sum2, std::plus<mean_scalar_type>(), root);
+                            invalidate_cache();
 
                         } else
                             const_cast<Accumulator<T, binning_analysis_tag, B> const *>(this)->collective_merge(comm, root);
@@ -412,14 +512,106 @@ namespace alps {
                             }
                         }
                     }
+
+                    void pack_shape(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack_shape(buffer);
+                        buffer.add_shape(m_ac_count.size());
+                    }
+                    void pack_gather(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack_gather(buffer);
+                        buffer.shape();
+                    }
+                    void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack(buffer);
+                        std::size_t size = buffer.shape();
+                        std::vector<typename count_type<B>::type> count(m_ac_count);
+                        count.resize(size);
+                        for (std::size_t i = 0; i < size; ++i)
+                            buffer.pack_count(count[i]);
+                        std::vector<T> sum(m_ac_sum);
+                        sum.resize(size);
+                        alps::numeric::rectangularize(sum);
+                        buffer.pack(sum);
+                        std::vector<T> sum2(m_ac_sum2);
+                        sum2.resize(size);
+                        alps::numeric::rectangularize(sum2);
+                        buffer.pack(sum2);
+                    }
+                    void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                        B::unpack(buffer);
+                        std::size_t size = buffer.shape();
+                        m_ac_count.resize(size);
+                        for (std::size_t i = 0; i < size; ++i)
+                            m_ac_count[i] = buffer.unpack_count();
+                        m_ac_sum.resize(size);
+                        alps::numeric::rectangularize(m_ac_sum);
+                        buffer.unpack(m_ac_sum);
+                        m_ac_sum2.resize(size);
+                        alps::numeric::rectangularize(m_ac_sum2);
+                        buffer.unpack(m_ac_sum2);
+                        invalidate_cache();
+                    }
 #endif
 
                 private:
 
+                    /// Add the sample `val`, which brings the count to `cnt`, to the binning level `i`
+                    void add_to_level(std::size_t i, typename count_type<B>::type cnt, T const & val) {
+                        using alps::numeric::add_to;
+                        using alps::numeric::add_square;
+                        using alps::numeric::set_zero_like;
+
+                        add_to(m_ac_partial[i], val);
+
+                        // in other words: (cnt % (1L << i) == 0)
+                        if (!(cnt & ((1ll << i) - 1))) {
+                            add_square(m_ac_sum2[i], m_ac_partial[i]);
+                            add_to(m_ac_sum[i], m_ac_partial[i]);
+                            m_ac_count[i]++;
+                            set_zero_like(m_ac_partial[i], val);
+                        }
+                    }
+
+                    /// Recompute the cached values if a bin closed at the lowest binning level they depend on
+                    /** `converged_errors()` uses the levels from `m_ac_count.size() - 11` up; a bin
+                        closing at any of them closes one at the lowest, so its bin count and
+                        the number of levels tell whether the cached values are current. */
+                    void update_cache() const {
+                        const std::size_t depth = m_ac_count.size();
+                        const std::size_t level = depth < 11 ? 0 : depth - 11;
+                        const typename count_type<B>::type count = depth ? m_ac_count[level] : typename count_type<B>::type();
+                        if (m_cache.valid && m_cache.depth == depth && m_cache.count == count)
+                            return;
+                        m_cache.error = error();
+                        m_cache.converged = converged_errors();
+                        m_cache.autocorrelation = autocorrelation();
+                        m_cache.mean = this->mean();
+                        m_cache.depth = depth;
+                        m_cache.count = count;
+                        m_cache.valid = true;
+                    }
+
+                    /// Mark the cached values as out of date, after a change other than adding samples
+                    void invalidate_cache() {
+                        m_cache.valid = false;
+                    }
+
+                    struct cache_type {
+                        cache_type(): valid(false), depth(), count() {}
+                        bool valid;
+                        std::size_t depth;
+                        typename count_type<B>::type count;
+                        typename alps::accumulators::error_type<B>::type error;
+                        typename alps::accumulators::convergence_type<B>::type converged;
+                        typename autocorrelation_type<B>::type autocorrelation;
+                        typename mean_type<B>::type mean;
+                    };
+
                     std::vector<T> m_ac_sum;
                     std::vector<T> m_ac_sum2;
                     std::vector<T> m_ac_partial;
                     std::vector<typename count_type<B>::type> m_ac_count;
+                    mutable cache_type m_cache;
             };
 
             // TODO: remove autocorrelation on any transform
@@ -461,6 +653,11 @@ namespace alps {
                         return m_ac_autocorrelation;
                     }
 
+                    bool reached_precision(double /*relative_error*/) const {
+                        throw std::runtime_error("The convergence is tracked by the accumulator, not by its result" + ALPS_STACKTRACE);
+                        return false;
+                    }
+
                     template<typename S> void print(S & os, bool terse=false) const {
                         if (terse) {
                             os << alps::short_print(this->mean())
@@ -739,6 +936,7 @@ namespace alps {
                 public:
                     virtual bool has_autocorrelation() const = 0;
                     virtual typename autocorrelation_type<B>::type autocorrelation() const = 0;
+                    virtual bool reached_precision(double relative_error) const = 0;
             };
 
             template<typename T, typename B> class DerivedWrapper<T, binning_analysis_tag, B> : public B {
@@ -749,6 +947,8 @@ namespace alps {
                     bool has_autocorrelation() const { return has_feature<T, binning_analysis_tag>::type::value; }
 
                     typename autocorrelation_type<B>::type autocorrelation() const { return detail::autocorrelation_impl(this->m_data); }
+
+                    bool reached_precision(double relative_error) const { return detail::reached_precision_impl(this->m_data, relative_error); }
             };
 
         }
@@ -11,6 +11,7 @@
 
 #include <alps/accumulators/feature.hpp>
 #include <alps/accumulators/parameter.hpp>
+#include <alps/accumulators/computed.hpp>
 
 #include <alps/hdf5/archive.hpp>
 #include <alps/utilities/stacktrace.hpp>
@@ -87,6 +88,14 @@ namespace alps {
                         throw std::runtime_error("No values can be added to a result" + ALPS_STACKTRACE);
                     }
 
+                    void add_range(T const *, T const *) {
+                        throw std::runtime_error("No values can be added to a result" + ALPS_STACKTRACE);
+                    }
+
+                    void add_computed(computed<typename detail::computed_element<T>::type> const &) {
+                        throw std::runtime_error("No values can be added to a result" + ALPS_STACKTRACE);
+                    }
+
                     template<typename S> void print(S & os, bool /*terse*/=false) const {
                         os << " #" << alps::short_print(count());
                     }
@@ -201,6 +210,16 @@ namespace alps {
                         throw std::runtime_error("Observable has no binary call operator" + ALPS_STACKTRACE);
                     }
 
+                    /// Add the samples in [first, last), in order; same as calling operator() for each of them
+                    void add_range(T const * first, T const * last) {
+                        m_count += last - first;
+                    }
+
+                    /// Add the computed sample `src` (see `detail::add_computed`)
+                    void add_computed(computed<typename detail::computed_element<T>::type> const &) {
+                        ++m_count;
+                    }
+
                     template<typename S> void print(S & os, bool /*terse*/=false) const {
                         os << " #" << alps::short_print(count());
                     }
@@ -257,6 +276,15 @@ namespace alps {
                         else
                             alps::alps_mpi::reduce(comm, m_count, std::plus<count_type>(), root);
                     }
+
+                    void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack(buffer);
+                        buffer.pack_count(m_count);
+                    }
+                    void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                        B::unpack(buffer);
+                        m_count = buffer.unpack_count();
+                    }
 #endif
 
                 private:
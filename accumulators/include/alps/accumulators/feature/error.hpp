@@ -18,6 +18,7 @@
 #include <alps/numeric/inf.hpp>
 #include <alps/numeric/check_size.hpp>
 #include <alps/numeric/vector_functions.hpp>
+#include <alps/accumulators/inplace_eigen.hpp>
 #include <alps/numeric/boost_array_functions.hpp>
  
 #include <alps/utilities/stacktrace.hpp>
@@ -101,15 +102,28 @@ namespace alps {
 
                     using B::operator();
                     void operator()(T const & val) {
-                        using alps::numeric::operator*;
-                        using alps::numeric::operator+=;
                         using alps::numeric::check_size;
+                        using alps::numeric::add_square;
 
                         B::operator()(val);
                         check_size(m_sum2, val);
-                        m_sum2 += val * val;
+                        add_square(m_sum2, val);
+                    }
+
+                    void add_range(T const * first, T const * last) {
+                        using alps::numeric::check_size;
+                        using alps::numeric::add_square;
+
+                        B::add_range(first, last);
+                        for (; first != last; ++first) {
+                            check_size(m_sum2, *first);
+                            add_square(m_sum2, *first);
+                        }
                     }
 
+                    /// The square of a computed sample needs the sample: `detail::add_computed` evaluates it
+                    void add_computed(computed<typename detail::computed_element<T>::type> const &) = delete;
+
                     template<typename S> void print(S & os, bool terse=false) const {
                         B::print(os, terse);
                         os << " +/-" << alps::short_print(error());
@@ -179,6 +193,15 @@ namespace alps {
                         else
                             B::reduce_if(comm, m_sum2, std::plus<typename alps::hdf5::scalar_type<T>::type>(), root);
                     }
+
+                    void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack(buffer);
+                        buffer.pack(m_sum2);
+                    }
+                    void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                        B::unpack(buffer);
+                        buffer.unpack(m_sum2);
+                    }
 #endif
 
                 private:
@@ -19,6 +19,9 @@
 #include <alps/numeric/boost_array_functions.hpp>
 #include <alps/numeric/check_size.hpp>
 #include <alps/numeric/vector_functions.hpp>
+#include <alps/accumulators/inplace_eigen.hpp>
+#include <alps/accumulators/timeseries_spill.hpp>
+#include <alps/accumulators/bin_slab.hpp>
 #include <alps/hdf5/archive.hpp>
 #include <alps/utilities/stacktrace.hpp>
 #include <alps/utilities/short_print.hpp>
@@ -29,10 +32,15 @@
 #include <boost/mpl/if.hpp>
 #include <boost/utility.hpp>
 #include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/type_traits/is_scalar.hpp>
 #include <boost/type_traits/is_integral.hpp>
+#include <boost/type_traits/is_same.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <stdexcept>
+#include <algorithm>
+#include <utility>
 
 namespace alps {
     namespace accumulators {
@@ -157,6 +165,9 @@ namespace alps {
                     , m_mn_elements_in_bin(0)
                     , m_mn_elements_in_partial(0)
                     , m_mn_partial(T())
+                    , m_mn_in_slab(false)
+                    , m_mn_synced_bins(0)
+                    , m_mn_saved_bins(0)
                 {}
 
                 Accumulator(Accumulator const & arg)
@@ -165,19 +176,36 @@ namespace alps {
                     , m_mn_elements_in_bin(arg.m_mn_elements_in_bin)
                     , m_mn_elements_in_partial(arg.m_mn_elements_in_partial)
                     , m_mn_partial(arg.m_mn_partial)
-                    , m_mn_bins(arg.m_mn_bins)
+                    , m_mn_bins(arg.bins())
+                    , m_mn_spill(arg.m_mn_spill ? arg.m_mn_spill->clone() : boost::shared_ptr<detail::timeseries_spill<T> >())
+                    , m_mn_in_slab(false)
+                    , m_mn_synced_bins(0)
+                    , m_mn_saved_bins(0)
                 {}
 
+                /// Named-argument constructor
+                /** If `spill_file` is given, the time series is also streamed to that HDF5 file,
+                    in bins of `spill_bin_size` samples (default: 1, i.e. every sample), to the
+                    dataset `/timeseries/<name>`. A copy of the accumulator streams the samples added
+                    to it to a dataset of its own (`/timeseries/<name>.1`, ...); under MPI, each process
+                    writes its own file (see `detail::spill_file_of_process`). */
                 template<typename ArgumentPack> Accumulator(ArgumentPack const & args, typename boost::disable_if<is_accumulator<ArgumentPack>, int>::type = 0)
                     : B(args)
                     , m_mn_max_number(args[max_bin_number | 128])
                     , m_mn_elements_in_bin(0)
                     , m_mn_elements_in_partial(0)
                     , m_mn_partial(T())
-                {}
+                    , m_mn_in_slab(false)
+                    , m_mn_synced_bins(0)
+                    , m_mn_saved_bins(0)
+                {
+                    std::string const file = args[spill_file | std::string()];
+                    if (!file.empty())
+                        m_mn_spill.reset(new detail::timeseries_spill<T>(file, args[accumulator_name | std::string()], args[spill_bin_size | 1]));
+                }
 
                 max_num_binning_type const max_num_binning() const {
-                    return max_num_binning_type(m_mn_bins, m_mn_elements_in_bin, m_mn_max_number);
+                    return max_num_binning_type(bins(), m_mn_elements_in_bin, m_mn_max_number);
                 }
 
                 template <typename OP> void transform(OP) {
@@ -190,42 +218,15 @@ namespace alps {
 
                 using B::operator();
                 void operator()(T const & val) {
-                    using alps::numeric::operator+=;
-                    using alps::numeric::operator+;
-                    using alps::numeric::operator/;
-                    using alps::numeric::check_size;
-
                     B::operator()(val);
+                    add_to_bins(val);
+                }
 
-                    if (!m_mn_elements_in_bin) {
-                        m_mn_bins.push_back(val);
-                        m_mn_elements_in_bin = 1;
-                    } else {
-                        check_size(m_mn_bins[0], val);
-                        check_size(m_mn_partial, val);
-                        m_mn_partial += val;
-                        ++m_mn_elements_in_partial;
-                    }
-
-                    // TODO: make library for scalar type
-                    typename alps::numeric::scalar<T>::type elements_in_bin = m_mn_elements_in_bin;
-                    typename alps::numeric::scalar<typename mean_type<B>::type>::type two = 2;
-
-                    if (m_mn_elements_in_partial == m_mn_elements_in_bin && m_mn_bins.size() >= m_mn_max_number) {
-                        if (m_mn_max_number % 2 == 1) {
-                            m_mn_partial += m_mn_bins[m_mn_max_number - 1];
-                            m_mn_elements_in_partial += m_mn_elements_in_bin;
-                        }
-                        for (typename count_type<T>::type i = 0; i < m_mn_max_number / 2; ++i)
-                            m_mn_bins[i] = (m_mn_bins[2 * i] + m_mn_bins[2 * i + 1]) / two;
-                        m_mn_bins.erase(m_mn_bins.begin() + m_mn_max_number / 2, m_mn_bins.end());
-                        m_mn_elements_in_bin *= (typename count_type<T>::type)2;
-                    }
-                    if (m_mn_elements_in_partial == m_mn_elements_in_bin) {
-                        m_mn_bins.push_back(m_mn_partial / elements_in_bin);
-                        m_mn_partial = T();
-                        m_mn_elements_in_partial = 0;
-                    }
+                /// Add the samples in [first, last); the result is the same as adding them one by one
+                void add_range(T const * first, T const * last) {
+                    B::add_range(first, last);
+                    for (; first != last; ++first)
+                        add_to_bins(*first);
                 }
 
                 template<typename S> void print(S & os, bool terse=false) const {
@@ -252,15 +253,18 @@ namespace alps {
                         ar["timeseries/partialbin"] = m_mn_partial;
                         ar["timeseries/partialbin/@count"] = m_mn_elements_in_partial;
                     }
-                    ar["timeseries/data"] = m_mn_bins;
+                    save_bins(ar, boost::integral_constant<bool, detail::spill_traits<typename mean_type<B>::type>::supported>());
                     ar["timeseries/data/@binningtype"] = "linear";
                     ar["timeseries/data/@minbinsize"] = 0; // TODO: what should we put here?
                     ar["timeseries/data/@binsize"] = m_mn_elements_in_bin;
                     ar["timeseries/data/@maxbinnum"] = m_mn_max_number;
+                    if (m_mn_spill)
+                        m_mn_spill->save(ar);
                 }
 
                 void load(hdf5::archive & ar) { // TODO: make archive const
                     B::load(ar);
+                    m_mn_in_slab = false;
                     ar["timeseries/data"] >> m_mn_bins;
                     ar["timeseries/data/@binsize"] >> m_mn_elements_in_bin;
                     ar["timeseries/data/@maxbinnum"] >> m_mn_max_number;
@@ -268,6 +272,11 @@ namespace alps {
                         ar["timeseries/partialbin"] >> m_mn_partial;
                         ar["timeseries/partialbin/@count"] >> m_mn_elements_in_partial;
                     }
+                    m_mn_saved_bins = 0;
+                    if (ar.is_data("timeseries/spill/bins"))
+                        m_mn_spill = detail::load_timeseries_spill<T>(ar);
+                    else if (m_mn_spill)
+                        m_mn_spill->reset();
                 }
 
                 static std::size_t rank() { return B::rank() + 1; }
@@ -295,18 +304,97 @@ namespace alps {
                     m_mn_elements_in_partial = typename B::count_type();
                     m_mn_partial = T();
                     m_mn_bins = std::vector<typename mean_type<B>::type>();
+                    m_mn_in_slab = false;
+                    m_mn_slab.clear();
+                    m_mn_saved_bins = 0;
+                    if (m_mn_spill)
+                        m_mn_spill->reset();
                 }
 
                 /// Merge the bins of the given accumulator of type A into this accumulator @param rhs Accumulator to merge
-                    /** @warning: FIXME: Incomplete, therefore always throws. */
+                /** The bins of both accumulators are first brought to the larger of the two
+                    bin sizes by averaging consecutive bins. The bins of `rhs` are then appended
+                    to the bins of this accumulator, and pairs of bins are averaged until the
+                    maximal number of bins is respected.
+
+                    The samples which are not in a complete bin (the partial bins of both
+                    accumulators, the bins left over by averaging) are collected in the partial
+                    bin. While they amount to a bin or more, a bin's worth of them (at their
+                    average) forms one more bin, so that the count is always the number of bins
+                    times the bin size plus the count of the partial bin.
+
+                    A spilled time series is not merged: the stream of each accumulator holds the
+                    samples added to that accumulator.
+                */
                 template <typename A>
                 void merge(const A& rhs)
                 {
-                        throw std::logic_error("Merging of FullBinningAccumulators is not yet implemented.\n"
-                                               "Please contact ALPSCore developers and provide the code\n"
-                                               "where you are using the merge() method.");
+                    using alps::numeric::operator+=;
+                    using alps::numeric::operator-;
+                    using alps::numeric::operator*;
+                    using alps::numeric::operator/;
+                    using alps::numeric::check_size;
+                    using alps::numeric::set_zero_like;
+                    using alps::numeric::assign_pair_average;
+                    typedef typename B::count_type count_t;
+                    typedef typename alps::numeric::scalar<typename mean_type<B>::type>::type scalar_t;
+
                     B::merge(rhs);
-                    // FIXME!!! Needs a test to proceed with the coding!
+                    if (!rhs.m_mn_elements_in_bin)
+                        return;
+                    m_mn_saved_bins = 0;
+                    modify_bins();
+                    if (!m_mn_elements_in_bin) {
+                        m_mn_bins = rhs.bins();
+                        m_mn_elements_in_bin = rhs.m_mn_elements_in_bin;
+                        m_mn_partial = rhs.m_mn_partial;
+                        m_mn_elements_in_partial = rhs.m_mn_elements_in_partial;
+                        return;
+                    }
+
+                    const count_t bin_size = std::max(m_mn_elements_in_bin, rhs.m_mn_elements_in_bin);
+                    if (bin_size % m_mn_elements_in_bin || bin_size % rhs.m_mn_elements_in_bin)
+                        throw std::runtime_error("Cannot merge FullBinningAccumulators with bin sizes "
+                                                 + boost::lexical_cast<std::string>(m_mn_elements_in_bin) + " and "
+                                                 + boost::lexical_cast<std::string>(rhs.m_mn_elements_in_bin)
+                                                 + ALPS_STACKTRACE);
+
+                    if (rhs.m_mn_elements_in_partial) {
+                        check_size(m_mn_partial, rhs.m_mn_partial);
+                        m_mn_partial += rhs.m_mn_partial;
+                        m_mn_elements_in_partial += rhs.m_mn_elements_in_partial;
+                    }
+
+                    rebin_to(m_mn_bins, m_mn_elements_in_bin, bin_size);
+                    std::vector<typename mean_type<B>::type> rhs_bins(rhs.bins());
+                    rebin_to(rhs_bins, rhs.m_mn_elements_in_bin, bin_size);
+                    m_mn_bins.insert(m_mn_bins.end(), rhs_bins.begin(), rhs_bins.end());
+                    m_mn_elements_in_bin = bin_size;
+
+                    const scalar_t two = 2;
+                    while (true) {
+                        if (m_mn_bins.size() > m_mn_max_number) {
+                            if (m_mn_bins.size() % 2 == 1) {
+                                move_to_partial(m_mn_bins.back(), m_mn_elements_in_bin);
+                                m_mn_bins.pop_back();
+                            }
+                            for (std::size_t i = 0; i < m_mn_bins.size() / 2; ++i)
+                                assign_pair_average(m_mn_bins[i], m_mn_bins[2 * i], m_mn_bins[2 * i + 1], two);
+                            m_mn_bins.resize(m_mn_bins.size() / 2);
+                            m_mn_elements_in_bin *= 2;
+                        } else if (m_mn_elements_in_partial >= m_mn_elements_in_bin) {
+                            // the new bin takes exactly one bin's worth of the samples of the partial bin
+                            const scalar_t elements_in_partial = m_mn_elements_in_partial;
+                            const scalar_t elements_in_bin = m_mn_elements_in_bin;
+                            m_mn_bins.push_back(m_mn_partial / elements_in_partial);
+                            m_mn_elements_in_partial -= m_mn_elements_in_bin;
+                            if (m_mn_elements_in_partial)
+                                m_mn_partial = m_mn_partial - m_mn_bins.back() * elements_in_bin;
+                            else
+                                set_zero_like(m_mn_partial, m_mn_bins.back());
+                        } else
+                            break;
+                    }
                 }
 
 #ifdef ALPS_HAVE_MPI
@@ -315,7 +403,8 @@ namespace alps {
                 {
                     if (comm.rank() == root) {
                         B::collective_merge(comm, root);
-                        if (!m_mn_bins.empty()) {
+                        m_mn_saved_bins = 0;
+                        if (!modify_bins().empty()) {
                             std::vector<typename mean_type<B>::type> local_bins(m_mn_bins), merged_bins;
                             partition_bins(comm, local_bins, merged_bins, root);
                             B::reduce_if(comm,
@@ -334,24 +423,76 @@ namespace alps {
                     B::collective_merge(comm, root);
                     if (comm.rank() == root)
                         throw std::runtime_error("A const object cannot be root" + ALPS_STACKTRACE);
-                    else if (!m_mn_bins.empty()) {
-                        std::vector<typename mean_type<B>::type> local_bins(m_mn_bins), merged_bins;
+                    else if (!bins().empty()) {
+                        std::vector<typename mean_type<B>::type> local_bins(bins()), merged_bins;
                         partition_bins(comm, local_bins, merged_bins, root);
                         B::reduce_if(comm, merged_bins, std::plus<typename alps::hdf5::scalar_type<typename mean_type<B>::type>::type>(), root);
                     }
                 }
 
+                void pack_shape(alps::alps_mpi::packed_reduction & buffer) const {
+                    B::pack_shape(buffer);
+                    buffer.add_shape(m_mn_elements_in_bin);
+                }
+                void pack_gather(alps::alps_mpi::packed_reduction & buffer) const {
+                    B::pack_gather(buffer);
+                    typename B::count_type elements_in_local_bins = buffer.shape();
+                    std::vector<typename mean_type<B>::type> local_bins(bins());
+                    rebin_local_bins(local_bins, elements_in_local_bins);
+                    buffer.add_gather(local_bins.size());
+                }
+                void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                    B::pack(buffer);
+                    typename B::count_type elements_in_local_bins = buffer.shape();
+                    std::vector<std::size_t> index(buffer.gathered());
+                    if (!elements_in_local_bins)
+                        return;
+                    std::vector<typename mean_type<B>::type> local_bins(bins()), merged_bins;
+                    rebin_local_bins(local_bins, elements_in_local_bins);
+                    place_bins(local_bins, index, buffer.rank(), B::mean(), merged_bins);
+                    buffer.pack(merged_bins);
+                }
+                void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                    using alps::numeric::check_size;
+                    B::unpack(buffer);
+                    m_mn_in_slab = false;
+                    m_mn_saved_bins = 0;
+                    typename B::count_type elements_in_local_bins = buffer.shape();
+                    std::vector<std::size_t> index(buffer.gathered());
+                    if (!elements_in_local_bins)
+                        return;
+                    std::size_t total_bins = std::accumulate(index.begin(), index.end(), std::size_t(0));
+                    typename mean_type<B>::type const like = B::mean();
+                    std::size_t perbin = total_bins < m_mn_max_number ? 1 : total_bins / m_mn_max_number;
+                    m_mn_bins.resize(perbin == 1 ? total_bins : m_mn_max_number);
+                    for (typename std::vector<typename mean_type<B>::type>::iterator it = m_mn_bins.begin(); it != m_mn_bins.end(); ++it)
+                        check_size(*it, like);
+                    buffer.unpack(m_mn_bins);
+                }
+
               private:
                 void partition_bins(alps::mpi::communicator const & comm,
                                     std::vector<typename mean_type<B>::type> & local_bins,
                                     std::vector<typename mean_type<B>::type> & merged_bins,
                                     int /*root*/) const
+                {
+                    typename B::count_type elements_in_local_bins = alps::mpi::all_reduce(comm, m_mn_elements_in_bin, alps::mpi::maximum<typename B::count_type>());
+                    rebin_local_bins(local_bins, elements_in_local_bins);
+
+                    std::vector<std::size_t> index(comm.size());
+                    alps::mpi::all_gather(comm, local_bins.size(), index);
+                    place_bins(local_bins, index, comm.rank(), local_bins[0], merged_bins);
+                }
+
+                /// Average the local bins into bins of (at least) `elements_in_local_bins` elements, the largest bin size of all processes
+                void rebin_local_bins(std::vector<typename mean_type<B>::type> & local_bins,
+                                      typename B::count_type elements_in_local_bins) const
                 {
                     using alps::numeric::operator+;
                     using alps::numeric::operator/;
-                    using alps::numeric::check_size;
 
-                    typename B::count_type elements_in_local_bins = alps::mpi::all_reduce(comm, m_mn_elements_in_bin, alps::mpi::maximum<typename B::count_type>());
+                    if (local_bins.empty())
+                        return;
                     typename B::count_type howmany = (elements_in_local_bins - 1) / m_mn_elements_in_bin + 1;
                     if (howmany > 1) {
                         typename B::count_type newbins = local_bins.size() / howmany;
@@ -364,18 +505,29 @@ namespace alps {
                         }
                             local_bins.resize(newbins);
                     }
+                }
+
+                /// Place the local bins of process `rank` into the merged bins, given the numbers of local bins on all processes in `index`
+                /** The merged bins are shaped like `like`. */
+                void place_bins(std::vector<typename mean_type<B>::type> const & local_bins,
+                                std::vector<std::size_t> const & index,
+                                int rank,
+                                typename mean_type<B>::type const & like,
+                                std::vector<typename mean_type<B>::type> & merged_bins) const
+                {
+                    using alps::numeric::operator+;
+                    using alps::numeric::operator/;
+                    using alps::numeric::check_size;
 
-                    std::vector<std::size_t> index(comm.size());
-                    alps::mpi::all_gather(comm, local_bins.size(), index);
                     std::size_t total_bins = std::accumulate(index.begin(), index.end(), 0);
                     std::size_t perbin = total_bins < m_mn_max_number ? 1 : total_bins / m_mn_max_number;
                     typename alps::numeric::scalar<typename mean_type<B>::type>::type perbin_vt = perbin;
 
                     merged_bins.resize(perbin == 1 ? total_bins : m_mn_max_number);
                     for (typename std::vector<typename mean_type<B>::type>::iterator it = merged_bins.begin(); it != merged_bins.end(); ++it)
-                        check_size(*it, local_bins[0]);
+                        check_size(*it, like);
 
-                    std::size_t start = std::accumulate(index.begin(), index.begin() + comm.rank(), 0);
+                    std::size_t start = std::accumulate(index.begin(), index.begin() + rank, 0);
                     for (std::size_t i = start / perbin, j = start % perbin, k = 0; i < merged_bins.size() && k < local_bins.size(); ++k) {
                         merged_bins[i] = merged_bins[i] + local_bins[k] / perbin_vt;
                         if (++j == perbin)
@@ -386,10 +538,231 @@ namespace alps {
 
               private:
 
+                /// Average groups of consecutive bins of size `elements_in_bin` into bins of size `new_elements_in_bin`
+                /** The bins left over at the end are moved to the partial bin */
+                void rebin_to(std::vector<typename mean_type<B>::type> & bins,
+                              typename B::count_type elements_in_bin,
+                              typename B::count_type new_elements_in_bin)
+                {
+                    using alps::numeric::operator+;
+                    using alps::numeric::operator/;
+
+                    const typename B::count_type howmany = new_elements_in_bin / elements_in_bin;
+                    if (howmany == 1)
+                        return;
+                    const typename alps::numeric::scalar<typename mean_type<B>::type>::type howmany_vt = howmany;
+                    const std::size_t newbins = bins.size() / howmany;
+                    for (std::size_t i = newbins * howmany; i < bins.size(); ++i)
+                        move_to_partial(bins[i], elements_in_bin);
+                    for (std::size_t i = 0; i < newbins; ++i) {
+                        typename mean_type<B>::type sum = bins[howmany * i];
+                        for (std::size_t j = 1; j < howmany; ++j)
+                            sum = sum + bins[howmany * i + j];
+                        bins[i] = sum / howmany_vt;
+                    }
+                    bins.resize(newbins);
+                }
+
+                /// Add the samples of the bin `bin` of size `elements_in_bin` to the partial bin
+                void move_to_partial(typename mean_type<B>::type const & bin, typename B::count_type elements_in_bin) {
+                    using alps::numeric::operator+=;
+                    using alps::numeric::operator*;
+                    using alps::numeric::check_size;
+
+                    const typename alps::numeric::scalar<typename mean_type<B>::type>::type elements_vt = elements_in_bin;
+                    check_size(m_mn_partial, bin);
+                    m_mn_partial += bin * elements_vt;
+                    m_mn_elements_in_partial += elements_in_bin;
+                }
+
+                /// Writes the bins; if `ar` holds the bins of the last save, only the new bins are appended
+                /** The bins are appended to a chunked dataset, which reads the same as the
+                    dataset written for other value types. Bins held by the slab are written
+                    directly from it. */
+                void save_bins(hdf5::archive & ar, boost::true_type) const {
+                    typedef detail::spill_traits<typename mean_type<B>::type> traits;
+                    typedef typename traits::scalar_type scalar_type;
+                    const char path[] = "timeseries/data";
+
+                    const std::size_t nbins = m_mn_in_slab ? m_mn_slab.rows() : m_mn_bins.size();
+                    const std::size_t size = !nbins ? 0 : m_mn_in_slab ? m_mn_slab.row_size() : traits::size(m_mn_bins[0]);
+                    if (!size) {
+                        save_bins(ar, boost::false_type());
+                        return;
+                    }
+                    std::string const location = ar.get_filename() + ":" + ar.complete_path(path);
+                    std::size_t first = 0;
+                    if (ar.is_data(path)) {
+                        if (m_mn_saved_bins && location == m_mn_saved_location && ar.extent(path)[0] == m_mn_saved_bins)
+                            first = m_mn_saved_bins;
+                        else
+                            ar.delete_data(path);
+                    }
+                    if (first < nbins) {
+                        const std::size_t rows = nbins - first;
+                        std::vector<std::size_t> extent(1, rows), chunk(1, std::max<std::size_t>(1, std::min<std::size_t>(m_mn_max_number, 64)));
+                        if (traits::is_vector) {
+                            extent.push_back(size);
+                            chunk.push_back(size);
+                        }
+                        if (m_mn_in_slab)
+                            ar.append(path, m_mn_slab.row(first), extent, chunk);
+                        else if (traits::is_vector) {
+                            std::vector<scalar_type> buffer(rows * size);
+                            for (std::size_t i = 0; i < rows; ++i) {
+                                scalar_type const * row = traits::data(m_mn_bins[first + i]);
+                                std::copy(row, row + size, buffer.begin() + i * size);
+                            }
+                            ar.append(path, &buffer[0], extent, chunk);
+                        } else
+                            ar.append(path, traits::data(m_mn_bins[first]), extent, chunk);
+                    }
+                    m_mn_saved_bins = nbins;
+                    m_mn_saved_location = location;
+                }
+
+                void save_bins(hdf5::archive & ar, boost::false_type) const {
+                    ar["timeseries/data"] = bins();
+                    m_mn_saved_bins = 0;
+                }
+
+                /// The bins; if they are held by the slab, the rows not yet copied are copied to `m_mn_bins` first
+                std::vector<typename mean_type<B>::type> const & bins() const {
+                    if (m_mn_in_slab && (m_mn_synced_bins < m_mn_slab.rows() || m_mn_bins.size() != m_mn_slab.rows())) {
+                        m_mn_slab.copy_to(m_mn_bins, m_mn_synced_bins);
+                        m_mn_synced_bins = m_mn_slab.rows();
+                    }
+                    return m_mn_bins;
+                }
+
+                /// The bins, to be modified in `m_mn_bins`; the slab is refilled from them by the next sample
+                std::vector<typename mean_type<B>::type> & modify_bins() {
+                    bins();
+                    m_mn_in_slab = false;
+                    return m_mn_bins;
+                }
+
+                /// Add the sample `val` to the bins (the base features are updated by the caller)
+                void add_to_bins(T const & val) {
+                    if (m_mn_spill)
+                        (*m_mn_spill)(val);
+                    add_to_bins(val, boost::integral_constant<bool, detail::bin_slab<typename mean_type<B>::type>::enabled
+                                                                    && boost::is_same<T, typename mean_type<B>::type>::value>());
+                }
+
+                /// Add the sample `val` to the bins in the slab
+                void add_to_bins(T const & val, boost::true_type) {
+                    using alps::numeric::add_to;
+                    using alps::numeric::check_size;
+                    using alps::numeric::set_zero_like;
+                    typedef typename alps::numeric::scalar<T>::type scalar_t;
+
+                    if (!m_mn_in_slab) {
+                        m_mn_slab.assign(m_mn_bins, m_mn_max_number);
+                        m_mn_synced_bins = m_mn_bins.size();
+                        m_mn_in_slab = true;
+                    }
+                    if (!m_mn_elements_in_bin) {
+                        m_mn_slab.push_back(val.empty() ? 0 : &val[0], val.size(), scalar_t(1), m_mn_max_number);
+                        m_mn_elements_in_bin = 1;
+                    } else {
+                        if (val.size() != m_mn_slab.row_size())
+                            throw std::runtime_error("vectors must have the same size!" + ALPS_STACKTRACE);
+                        check_size(m_mn_partial, val);
+                        add_to(m_mn_partial, val);
+                        ++m_mn_elements_in_partial;
+                    }
+
+                    const scalar_t elements_in_bin = m_mn_elements_in_bin;
+                    const scalar_t two = 2;
+
+                    if (m_mn_elements_in_partial == m_mn_elements_in_bin && m_mn_slab.rows() >= m_mn_max_number) {
+                        if (m_mn_max_number % 2 == 1) {
+                            scalar_t const * last = m_mn_slab.row(m_mn_max_number - 1);
+                            for (std::size_t k = 0; k < m_mn_partial.size(); ++k)
+                                m_mn_partial[k] += last[k];
+                            m_mn_elements_in_partial += m_mn_elements_in_bin;
+                        }
+                        m_mn_slab.halve(m_mn_max_number / 2, two);
+                        m_mn_elements_in_bin *= (typename count_type<T>::type)2;
+                        m_mn_synced_bins = 0;
+                        m_mn_saved_bins = 0;
+                    }
+                    if (m_mn_elements_in_partial == m_mn_elements_in_bin) {
+                        m_mn_slab.push_back(m_mn_partial.empty() ? 0 : &m_mn_partial[0], m_mn_partial.size(), elements_in_bin);
+                        set_zero_like(m_mn_partial, val);
+                        m_mn_elements_in_partial = 0;
+                    }
+                }
+
+                /// Add the sample `val` to the bins in `m_mn_bins`
+                void add_to_bins(T const & val, boost::false_type) {
+                    using alps::numeric::operator+=;
+                    using alps::numeric::add_to;
+                    using alps::numeric::check_size;
+                    using alps::numeric::set_zero_like;
+                    using alps::numeric::assign_pair_average;
+                    using alps::numeric::assign_divided;
+
+                    if (!m_mn_elements_in_bin) {
+                        m_mn_bins.push_back(val);
+                        m_mn_elements_in_bin = 1;
+                    } else {
+                        check_size(m_mn_bins[0], val);
+                        check_size(m_mn_partial, val);
+                        add_to(m_mn_partial, val);
+                        ++m_mn_elements_in_partial;
+                    }
+
+                    // TODO: make library for scalar type
+                    typename alps::numeric::scalar<T>::type elements_in_bin = m_mn_elements_in_bin;
+                    typename alps::numeric::scalar<typename mean_type<B>::type>::type two = 2;
+
+                    if (m_mn_elements_in_partial == m_mn_elements_in_bin && m_mn_bins.size() >= m_mn_max_number) {
+                        if (m_mn_max_number % 2 == 1) {
+                            m_mn_partial += m_mn_bins[m_mn_max_number - 1];
+                            m_mn_elements_in_partial += m_mn_elements_in_bin;
+                        }
+                        for (typename count_type<T>::type i = 0; i < m_mn_max_number / 2; ++i)
+                            assign_pair_average(m_mn_bins[i], m_mn_bins[2 * i], m_mn_bins[2 * i + 1], two);
+                        // keep the storage of the dropped bins for reuse by the following bins
+                        for (std::size_t i = m_mn_max_number / 2; i < m_mn_bins.size(); ++i) {
+                            m_mn_spare_bins.push_back(typename mean_type<B>::type());
+                            std::swap(m_mn_spare_bins.back(), m_mn_bins[i]);
+                        }
+                        m_mn_bins.erase(m_mn_bins.begin() + m_mn_max_number / 2, m_mn_bins.end());
+                        m_mn_elements_in_bin *= (typename count_type<T>::type)2;
+                        m_mn_saved_bins = 0;
+                    }
+                    if (m_mn_elements_in_partial == m_mn_elements_in_bin) {
+                        if (m_mn_spare_bins.empty())
+                            m_mn_bins.push_back(typename mean_type<B>::type());
+                        else {
+                            m_mn_bins.push_back(std::move(m_mn_spare_bins.back()));
+                            m_mn_spare_bins.pop_back();
+                        }
+                        assign_divided(m_mn_bins.back(), m_mn_partial, elements_in_bin);
+                        set_zero_like(m_mn_partial, val);
+                        m_mn_elements_in_partial = 0;
+                    }
+                }
+
                 std::size_t m_mn_max_number;
                 typename B::count_type m_mn_elements_in_bin, m_mn_elements_in_partial;
                 T m_mn_partial;
-                std::vector<typename mean_type<B>::type> m_mn_bins;
+                /// The bins; while the slab holds them, a copy of its first `m_mn_synced_bins` rows
+                mutable std::vector<typename mean_type<B>::type> m_mn_bins;
+                /// Storage of bins dropped by rebinning, reused to avoid allocations (not part of the state)
+                std::vector<typename mean_type<B>::type> m_mn_spare_bins;
+                /// Stream of the time series to a file, if requested
+                boost::shared_ptr<detail::timeseries_spill<T> > m_mn_spill;
+                /// Contiguous storage of vector-valued bins while samples are added (see `bins()`)
+                detail::bin_slab<typename mean_type<B>::type> m_mn_slab;
+                bool m_mn_in_slab;
+                mutable std::size_t m_mn_synced_bins;
+                /// Number of leading bins unchanged since they were saved to `m_mn_saved_location` (not part of the state)
+                mutable std::size_t m_mn_saved_bins;
+                mutable std::string m_mn_saved_location;
             };
 
 
@@ -442,6 +815,28 @@ namespace alps {
                     , m_mn_jackknife_bins(0)
                 {}
 
+                /// A result of nonlinear operations, given by its binning analysis and its (transformed) bins and jackknife bins
+                Result(B const & base,
+                       std::vector<typename mean_type<B>::type> bins,
+                       std::vector<typename mean_type<B>::type> jackknife_bins,
+                       typename B::count_type elements_in_bin,
+                       std::size_t max_number)
+                    : B(base)
+                    , m_mn_max_number(max_number)
+                    , m_mn_elements_in_bin(elements_in_bin)
+                    , m_mn_bins()
+                    , m_mn_count(typename B::count_type())
+                    , m_mn_mean(typename mean_type<B>::type())
+                    , m_mn_error(typename error_type<B>::type())
+                    , m_mn_cannot_rebin(true)
+                    , m_mn_jackknife_valid(true)
+                    , m_mn_data_is_analyzed(false)
+                    , m_mn_jackknife_bins()
+                {
+                    m_mn_bins.swap(bins);
+                    m_mn_jackknife_bins.swap(jackknife_bins);
+                }
+
                 typename B::count_type count() const {
                     if (!m_mn_data_is_analyzed) {
                         return m_mn_elements_in_bin * m_mn_bins.size();
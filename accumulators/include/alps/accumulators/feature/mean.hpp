@@ -19,6 +19,7 @@
 #include <alps/numeric/boost_array_functions.hpp>
 #include <alps/numeric/check_size.hpp>
 #include <alps/numeric/vector_functions.hpp>
+#include <alps/accumulators/inplace_eigen.hpp>
 #include <alps/utilities/stacktrace.hpp>
 #include <alps/utilities/short_print.hpp>
 
@@ -94,12 +95,29 @@ namespace alps {
 
                     using B::operator();
                     void operator()(T const & val) {
-                        using alps::numeric::operator+=;
+                        using alps::numeric::add_to;
                         using alps::numeric::check_size;
 
                         B::operator()(val);
                         check_size(m_sum, val);
-                        m_sum += val;
+                        add_to(m_sum, val);
+                    }
+
+                    void add_range(T const * first, T const * last) {
+                        using alps::numeric::add_to;
+                        using alps::numeric::check_size;
+
+                        B::add_range(first, last);
+                        for (; first != last; ++first) {
+                            check_size(m_sum, *first);
+                            add_to(m_sum, *first);
+                        }
+                    }
+
+                    /// Add the computed sample `src` directly to the sum (see `detail::add_computed`)
+                    void add_computed(computed<typename detail::computed_element<T>::type> const & src) {
+                        B::add_computed(src);
+                        detail::add_computed_to(m_sum, src);
                     }
 
                     template<typename S> void print(S & os, bool terse=false) const {
@@ -169,6 +187,15 @@ namespace alps {
                         else
                             B::reduce_if(comm, m_sum, std::plus<typename alps::hdf5::scalar_type<T>::type>(), root);
                     }
+
+                    void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                        B::pack(buffer);
+                        buffer.pack(m_sum);
+                    }
+                    void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                        B::unpack(buffer);
+                        buffer.unpack(m_sum);
+                    }
 #endif
                 protected:
 
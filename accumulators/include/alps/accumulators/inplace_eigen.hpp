@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file inplace_eigen.hpp
+    @brief Eigen versions of the accumulation kernels for vectors of `float` and `double`
+
+    These overloads of the kernels in `alps/numeric/inplace_functions.hpp` map the
+    storage of the vectors to Eigen arrays, so that the sums of the accumulators
+    are updated with the explicitly vectorized (SIMD) expressions of Eigen, also
+    when the compiler does not vectorize the plain loops (e.g., at `-O2`). They are
+    exact matches for the vectors of `float` and `double` and are thus preferred
+    to the generic templates. The elements undergo the same floating point
+    operations as in the plain loops.
+*/
+
+#ifndef ALPS_ACCUMULATOR_INPLACE_EIGEN_HPP
+#define ALPS_ACCUMULATOR_INPLACE_EIGEN_HPP
+
+#include <alps/numeric/inplace_functions.hpp>
+
+#include <Eigen/Core>
+
+#include <vector>
+
+namespace alps {
+    namespace numeric {
+
+        namespace detail {
+            template<typename T> struct eigen_array_map {
+                typedef Eigen::Map<Eigen::Array<T, Eigen::Dynamic, 1> > type;
+                typedef Eigen::Map<const Eigen::Array<T, Eigen::Dynamic, 1> > const_type;
+            };
+
+            template<typename T> inline void add_to_eigen(std::vector<T> & acc, std::vector<T> const & x) {
+                check_same_size(acc.size(), x.size());
+                if (x.empty())
+                    return;
+                typename eigen_array_map<T>::type(&acc[0], acc.size()) += typename eigen_array_map<T>::const_type(&x[0], x.size());
+            }
+
+            template<typename T> inline void add_square_eigen(std::vector<T> & acc, std::vector<T> const & x) {
+                check_same_size(acc.size(), x.size());
+                if (x.empty())
+                    return;
+                typename eigen_array_map<T>::type(&acc[0], acc.size()) += typename eigen_array_map<T>::const_type(&x[0], x.size()).square();
+            }
+        }
+
+        /// Accumulate `x` into `acc` with Eigen
+        inline void add_to(std::vector<double> & acc, std::vector<double> const & x) {
+            detail::add_to_eigen(acc, x);
+        }
+        inline void add_to(std::vector<float> & acc, std::vector<float> const & x) {
+            detail::add_to_eigen(acc, x);
+        }
+
+        /// Accumulate the element-wise square of `x` into `acc` with Eigen
+        inline void add_square(std::vector<double> & acc, std::vector<double> const & x) {
+            detail::add_square_eigen(acc, x);
+        }
+        inline void add_square(std::vector<float> & acc, std::vector<float> const & x) {
+            detail::add_square_eigen(acc, x);
+        }
+
+    }
+}
+
+#endif // ALPS_ACCUMULATOR_INPLACE_EIGEN_HPP
@@ -17,6 +17,13 @@
 
     #include <cassert>
     #include <boost/lexical_cast.hpp> // for throw() message
+    #include <boost/cstdint.hpp>
+    #include <boost/type_traits/is_arithmetic.hpp>
+    #include <boost/utility/enable_if.hpp>
+
+    #include <vector>
+    #include <typeinfo>
+    #include <stdexcept>
 
     namespace alps {
         namespace alps_mpi {
@@ -262,6 +269,223 @@
                 reduce_impl(comm, in_values, out_values, op, root, typename boost::is_scalar<T>::type(), typename hdf5::is_content_continuous<T>::type());
             }
 
+            /// Buffers to merge the state of many accumulators with a few collective operations
+            /** Every accumulator appends its state to the buffers in four passes, separated
+                by one collective operation each:
+
+                1. `pack_shape()` appends sizes (e.g. the number of binning levels) by
+                   `add_shape()`; the sizes are reduced by maximum on all processes.
+                2. `pack_gather()` appends per-process sizes by `add_gather()`; these are
+                   gathered on all processes.
+                3. `pack()` appends the values to be summed by `pack()` and `pack_count()`;
+                   the sums are reduced to the root process.
+                4. `unpack()` reads the merged values on the root process.
+
+                In every pass, an accumulator reads back the (reduced or gathered) entries it
+                appended in the earlier passes, in the same order, by `shape()` and `gathered()`.
+                All processes must append the same number of entries in passes 1 and 2.
+
+                With MPI-3, each collective operation can also be started without blocking
+                (`start_reduce_shape()`, `start_gather()`, `start_reduce()`) and completed by
+                `test()` or `wait()`.
+            */
+            class packed_reduction {
+                public:
+                    typedef boost::uint64_t count_type;
+
+                    packed_reduction(int rank)
+                        : m_rank(rank)
+                    {
+                        rewind();
+                    }
+
+                    /// Rank of this process
+                    int rank() const { return m_rank; }
+
+                    /// Restarts reading the buffers at their beginning
+                    void rewind() {
+                        m_shape_pos = m_gather_pos = m_count_pos = m_float_pos = m_double_pos = m_long_double_pos = 0;
+                    }
+
+                    void add_shape(std::size_t value) { m_shape.push_back(value); }
+                    std::size_t shape() { return m_shape.at(m_shape_pos++); }
+
+                    void add_gather(std::size_t value) { m_gather.push_back(value); }
+                    /// The values appended at this position on all processes, indexed by rank
+                    std::vector<std::size_t> gathered() {
+                        std::size_t const stride = m_gather.size();
+                        std::vector<std::size_t> values(m_gathered.size() / (stride ? stride : 1));
+                        for (std::size_t i = 0; i < values.size(); ++i)
+                            values[i] = m_gathered.at(i * stride + m_gather_pos);
+                        ++m_gather_pos;
+                        return values;
+                    }
+
+                    void pack_count(count_type value) { m_counts.push_back(value); }
+                    count_type unpack_count() { return m_counts.at(m_count_pos++); }
+
+                    template<typename T> typename boost::enable_if<boost::is_arithmetic<T> >::type pack(T const & value) {
+                        buffer((T *)NULL).push_back(value);
+                    }
+                    template<typename T> typename boost::enable_if<boost::is_arithmetic<T> >::type unpack(T & value) {
+                        value = buffer((T *)NULL).at(position((T *)NULL)++);
+                    }
+                    template<typename T> void pack(std::vector<T> const & values) {
+                        for (typename std::vector<T>::const_iterator it = values.begin(); it != values.end(); ++it)
+                            pack(*it);
+                    }
+                    /// Reads as many values as `values` holds
+                    template<typename T> void unpack(std::vector<T> & values) {
+                        for (typename std::vector<T>::iterator it = values.begin(); it != values.end(); ++it)
+                            unpack(*it);
+                    }
+                    template<typename T> typename boost::disable_if<boost::is_arithmetic<T> >::type pack(T const &) {
+                        throw std::logic_error("No alps::mpi::reduce available for this type " + std::string(typeid(T).name()) + ALPS_STACKTRACE);
+                    }
+                    template<typename T> typename boost::disable_if<boost::is_arithmetic<T> >::type unpack(T &) {
+                        throw std::logic_error("No alps::mpi::reduce available for this type " + std::string(typeid(T).name()) + ALPS_STACKTRACE);
+                    }
+
+                    /// Collective after pass 1: the shapes become their maxima over all processes
+                    void reduce_shape(alps::mpi::communicator const & comm) {
+                        if (m_shape.empty())
+                            return;
+                        std::vector<std::size_t> local(m_shape);
+                        alps::mpi::all_reduce(comm, &local.front(), local.size(), &m_shape.front(), alps::mpi::maximum<std::size_t>());
+                    }
+
+                    /// Collective after pass 2: gathers the per-process sizes on all processes
+                    void gather(alps::mpi::communicator const & comm) {
+                        if (m_gather.empty())
+                            return;
+                        m_gathered.resize(m_gather.size() * comm.size());
+                        MPI_Allgather(&m_gather.front(), m_gather.size(), alps::mpi::get_mpi_datatype(std::size_t()),
+                                      &m_gathered.front(), m_gather.size(), alps::mpi::get_mpi_datatype(std::size_t()),
+                                      comm);
+                    }
+
+                    /// Collective after pass 3: sums the values to the root process
+                    void reduce(alps::mpi::communicator const & comm, int root) {
+                        reduce_buffer(comm, m_counts, root);
+                        reduce_buffer(comm, m_floats, root);
+                        reduce_buffer(comm, m_doubles, root);
+                        reduce_buffer(comm, m_long_doubles, root);
+                    }
+
+#if MPI_VERSION >= 3
+                    /// Non-blocking version of `reduce_shape()`; complete it by `test()` or `wait()`
+                    void start_reduce_shape(alps::mpi::communicator const & comm) {
+                        if (m_shape.empty())
+                            return;
+                        m_sent_shape = m_shape;
+                        m_requests.push_back(MPI_Request());
+                        check_mpi_call(MPI_Iallreduce(&m_sent_shape.front(), &m_shape.front(), m_shape.size(),
+                                                      alps::mpi::get_mpi_datatype(std::size_t()), MPI_MAX, comm, &m_requests.back()),
+                                       "MPI_Iallreduce");
+                    }
+
+                    /// Non-blocking version of `gather()`; complete it by `test()` or `wait()`
+                    void start_gather(alps::mpi::communicator const & comm) {
+                        if (m_gather.empty())
+                            return;
+                        m_gathered.resize(m_gather.size() * comm.size());
+                        m_requests.push_back(MPI_Request());
+                        check_mpi_call(MPI_Iallgather(&m_gather.front(), m_gather.size(), alps::mpi::get_mpi_datatype(std::size_t()),
+                                                      &m_gathered.front(), m_gather.size(), alps::mpi::get_mpi_datatype(std::size_t()),
+                                                      comm, &m_requests.back()),
+                                       "MPI_Iallgather");
+                    }
+
+                    /// Non-blocking version of `reduce()`; complete it by `test()` or `wait()`
+                    void start_reduce(alps::mpi::communicator const & comm, int root) {
+                        start_reduce_buffer(comm, m_counts, m_sent_counts, root);
+                        start_reduce_buffer(comm, m_floats, m_sent_floats, root);
+                        start_reduce_buffer(comm, m_doubles, m_sent_doubles, root);
+                        start_reduce_buffer(comm, m_long_doubles, m_sent_long_doubles, root);
+                    }
+
+                    /// Whether the non-blocking operations started last are complete
+                    /** The buffers must not be read before they are. */
+                    bool test() {
+                        if (m_requests.empty())
+                            return true;
+                        int flag;
+                        check_mpi_call(MPI_Testall(m_requests.size(), &m_requests.front(), &flag, MPI_STATUSES_IGNORE), "MPI_Testall");
+                        if (flag)
+                            m_requests.clear();
+                        return flag;
+                    }
+
+                    /// Waits for the non-blocking operations started last to complete
+                    void wait() {
+                        if (m_requests.empty())
+                            return;
+                        check_mpi_call(MPI_Waitall(m_requests.size(), &m_requests.front(), MPI_STATUSES_IGNORE), "MPI_Waitall");
+                        m_requests.clear();
+                    }
+#endif
+
+                private:
+#if MPI_VERSION >= 3
+                    static void check_mpi_call(int rc, std::string const & name) {
+                        if (rc != MPI_SUCCESS)
+                            throw std::runtime_error(name + "() returned error code " + boost::lexical_cast<std::string>(rc) + ALPS_STACKTRACE);
+                    }
+
+                    /// The values are sent from `sent`, which must be kept until the reduction is complete
+                    template<typename S> void start_reduce_buffer(alps::mpi::communicator const & comm, std::vector<S> & values, std::vector<S> & sent, int root) {
+                        if (values.empty())
+                            return;
+                        sent.swap(values);
+                        values.clear();
+                        if (comm.rank() == root)
+                            values.resize(sent.size());
+                        m_requests.push_back(MPI_Request());
+                        check_mpi_call(MPI_Ireduce(&sent.front(), comm.rank() == root ? &values.front() : NULL, sent.size(),
+                                                   alps::mpi::get_mpi_datatype(S()), MPI_SUM, root, comm, &m_requests.back()),
+                                       "MPI_Ireduce");
+                    }
+#endif
+
+                    template<typename S> static void reduce_buffer(alps::mpi::communicator const & comm, std::vector<S> & values, int root) {
+                        if (values.empty())
+                            return;
+                        std::vector<S> local;
+                        local.swap(values);
+                        if (comm.rank() == root)
+                            values.resize(local.size());
+                        detail::checked_mpi_reduce(&local.front(), comm.rank() == root ? &values.front() : NULL, local.size(),
+                                                   alps::mpi::get_mpi_datatype(S()), MPI_SUM, root, comm);
+                    }
+
+                    std::vector<float> & buffer(float *) { return m_floats; }
+                    std::vector<double> & buffer(double *) { return m_doubles; }
+                    std::vector<long double> & buffer(long double *) { return m_long_doubles; }
+                    template<typename T> std::vector<T> & buffer(T *) {
+                        throw std::logic_error("No alps::mpi::reduce available for this type " + std::string(typeid(T).name()) + ALPS_STACKTRACE);
+                    }
+                    std::size_t & position(float *) { return m_float_pos; }
+                    std::size_t & position(double *) { return m_double_pos; }
+                    std::size_t & position(long double *) { return m_long_double_pos; }
+                    template<typename T> std::size_t & position(T *) { return m_double_pos; }
+
+                    int m_rank;
+                    std::vector<std::size_t> m_shape, m_gather, m_gathered;
+                    std::vector<count_type> m_counts;
+                    std::vector<float> m_floats;
+                    std::vector<double> m_doubles;
+                    std::vector<long double> m_long_doubles;
+#if MPI_VERSION >= 3
+                    std::vector<MPI_Request> m_requests;
+                    std::vector<std::size_t> m_sent_shape;
+                    std::vector<count_type> m_sent_counts;
+                    std::vector<float> m_sent_floats;
+                    std::vector<double> m_sent_doubles;
+                    std::vector<long double> m_sent_long_doubles;
+#endif
+                    std::size_t m_shape_pos, m_gather_pos, m_count_pos, m_float_pos, m_double_pos, m_long_double_pos;
+            };
+
         } // alps_mpi::
     } // alps::
 
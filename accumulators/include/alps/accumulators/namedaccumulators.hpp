@@ -144,6 +144,8 @@ namespace alps {
                     (required (_accumulator_name, (std::string)))
                     (optional
                         (_max_bin_number, (std::size_t))
+                        (_spill_file, (std::string))
+                        (_spill_bin_size, (std::size_t))
                     )
             )
             FullBinningAccumulator& operator=(const FullBinningAccumulator& rhs)
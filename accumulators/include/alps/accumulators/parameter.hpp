@@ -14,6 +14,8 @@ namespace alps {
 
         BOOST_PARAMETER_NAME((accumulator_name, accumulator_keywords) _accumulator_name)
         BOOST_PARAMETER_NAME((max_bin_number, accumulator_keywords) _max_bin_number)
+        BOOST_PARAMETER_NAME((spill_file, accumulator_keywords) _spill_file)
+        BOOST_PARAMETER_NAME((spill_bin_size, accumulator_keywords) _spill_bin_size)
 
     }
 }
@@ -0,0 +1,518 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file ratio_accumulator_set.hpp defines a set of sign-weighted observables sharing one sign accumulator */
+
+#ifndef ALPS_ACCUMULATOR_RATIO_ACCUMULATOR_SET_HPP
+#define ALPS_ACCUMULATOR_RATIO_ACCUMULATOR_SET_HPP
+
+#include <alps/config.hpp>
+#include <alps/hdf5/archive.hpp>
+#include <alps/hdf5/vector.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#ifdef ALPS_HAVE_MPI
+    #include <alps/accumulators/mpi.hpp>
+#endif
+
+#include <boost/cstdint.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <map>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+namespace alps {
+    namespace accumulators {
+
+        /// Estimate of a ratio <s·O>/<s>, with its jackknife error
+        class ratio_result {
+            public:
+                typedef boost::uint64_t count_type;
+
+                ratio_result(count_type count, std::vector<double> const & mean, std::vector<double> const & error)
+                    : m_count(count)
+                    , m_mean(mean)
+                    , m_error(error)
+                {}
+
+                /// Number of samples
+                count_type count() const { return m_count; }
+
+                /// Ratio of the sums of s·O and of s over all samples
+                std::vector<double> const & mean() const { return m_mean; }
+
+                /// Jackknife error of the ratio over the complete bins; infinite with fewer than two bins
+                std::vector<double> const & error() const { return m_error; }
+
+            private:
+                count_type m_count;
+                std::vector<double> m_mean;
+                std::vector<double> m_error;
+        };
+
+        /// A set of observables O weighted by a sign s shared by all of them, estimating <s·O>/<s>
+        /** Each sample starts with `sign(s)`; the observables measured in the sample are
+            then added by `set["name"] << value`, which records s·value. An observable not
+            measured in a sample counts as zero in that sample.
+
+            The sign and all observables share one bin size and are binned together, like a
+            `FullBinningAccumulator`: at most `max_bin_number` bins are kept and pairs of bins
+            are merged when the number is exceeded. The bins hold the sums of s and of s·O over
+            the samples of the bin, so that `result()` computes the ratio estimate and its
+            jackknife error directly from them, instead of dividing the results of two
+            accumulators.
+
+            Observables are scalars or `std::vector<double>` of a fixed length. A sample whose
+            observables are added after the next `sign()` call, after `merge()` or after
+            `load()` is rejected.
+
+            Example:
+            @code
+                ratio_accumulator_set measurements;
+                measurements.sign(s);
+                measurements["Energy"] << energy;
+                measurements["Green"] << green_function;
+                ratio_result energy = measurements.result("Energy");
+            @endcode
+        */
+        class ratio_accumulator_set {
+            public:
+                typedef boost::uint64_t count_type;
+
+                /// Adds the values of one observable to the current sample
+                class observable {
+                    public:
+                        observable(ratio_accumulator_set & set, std::string const & name)
+                            : m_set(set)
+                            , m_name(name)
+                        {}
+
+                        observable & operator<<(double value) {
+                            m_set.add(m_name, &value, 1);
+                            return *this;
+                        }
+
+                        observable & operator<<(std::vector<double> const & value) {
+                            if (value.empty())
+                                throw std::runtime_error("Zero-sized vector observables are not allowed" + ALPS_STACKTRACE);
+                            m_set.add(m_name, &value.front(), value.size());
+                            return *this;
+                        }
+
+                    private:
+                        ratio_accumulator_set & m_set;
+                        std::string m_name;
+                };
+
+                explicit ratio_accumulator_set(std::size_t max_bin_number = 128)
+                    : m_max_bin_number(max_bin_number)
+                {
+                    if (max_bin_number < 2)
+                        throw std::invalid_argument("A ratio_accumulator_set needs at least 2 bins" + ALPS_STACKTRACE);
+                    reset();
+                }
+
+                /// Starts a sample with sign (or weight) `s`
+                void sign(double s) {
+                    normalize();
+                    m_sign = s;
+                    m_in_sample = true;
+                    ++m_count;
+                    ++m_elements_in_partial;
+                    m_sign_sum += s;
+                    m_sign_partial += s;
+                }
+
+                /// The observable `name`, to which the values of the current sample are added
+                observable operator[](std::string const & name) {
+                    return observable(*this, name);
+                }
+
+                /// Adds s·value to the observable `name` of `size` elements, for the current sample
+                void add(std::string const & name, double const * value, std::size_t size) {
+                    if (!m_in_sample)
+                        throw std::logic_error("No sample started by ratio_accumulator_set::sign() for " + name + ALPS_STACKTRACE);
+                    series & obs = find_or_insert(name, size);
+                    for (std::size_t i = 0; i < size; ++i) {
+                        double const weighted = m_sign * value[i];
+                        obs.sum[i] += weighted;
+                        obs.partial[i] += weighted;
+                    }
+                }
+
+                /// Whether the observable `name` was measured
+                bool has(std::string const & name) const {
+                    return m_observables.find(name) != m_observables.end();
+                }
+
+                /// Names of the measured observables
+                std::vector<std::string> names() const {
+                    std::vector<std::string> result;
+                    for (storage_type::const_iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                        result.push_back(it->first);
+                    return result;
+                }
+
+                /// Number of samples
+                count_type count() const { return m_count; }
+
+                /// Number of samples in each bin
+                count_type bin_size() const { return m_elements_in_bin; }
+
+                /// Number of complete bins
+                std::size_t bin_number() const { return m_sign_bins.size(); }
+
+                std::size_t max_bin_number() const { return m_max_bin_number; }
+
+                void reset() {
+                    m_count = 0;
+                    m_elements_in_bin = 1;
+                    m_elements_in_partial = 0;
+                    m_sign = 0;
+                    m_in_sample = false;
+                    m_sign_sum = 0;
+                    m_sign_partial = 0;
+                    m_sign_bins.clear();
+                    m_observables.clear();
+                }
+
+                /// Ratio estimate <s·O>/<s> of the observable `name`
+                ratio_result result(std::string const & name) const {
+                    storage_type::const_iterator it = m_observables.find(name);
+                    if (it == m_observables.end())
+                        throw std::out_of_range("No observable found with the name: " + name + ALPS_STACKTRACE);
+                    series const & obs = it->second;
+                    std::size_t const size = obs.sum.size();
+
+                    std::vector<double> mean(size);
+                    for (std::size_t i = 0; i < size; ++i)
+                        mean[i] = obs.sum[i] / m_sign_sum;
+                    return ratio_result(m_count, mean, jackknife_error(complete_bins(obs.bins, obs.partial), size, complete_bins(m_sign_bins, std::vector<double>(1, m_sign_partial))));
+                }
+
+                /// Mean sign <s>, with the jackknife error of the mean over the complete bins
+                ratio_result sign_result() const {
+                    std::vector<double> bins(complete_bins(m_sign_bins, std::vector<double>(1, m_sign_partial)));
+                    return ratio_result(m_count, std::vector<double>(1, m_sign_sum / m_count), jackknife_error(bins, 1, std::vector<double>(bins.size(), m_elements_in_bin)));
+                }
+
+                /// Merges the samples of `rhs` into this set; the current sample ends
+                /** Observables measured in only one of the sets count as zero in the samples of the other. */
+                void merge(ratio_accumulator_set const & rhs) {
+                    m_in_sample = false;
+                    if (!rhs.m_count)
+                        return;
+                    ratio_accumulator_set other(rhs);
+                    count_type const bin_size = std::max(m_elements_in_bin, other.m_elements_in_bin);
+                    if (bin_size % m_elements_in_bin || bin_size % other.m_elements_in_bin)
+                        throw std::runtime_error("Cannot merge ratio_accumulator_sets with bin sizes "
+                                                 + boost::lexical_cast<std::string>(m_elements_in_bin) + " and "
+                                                 + boost::lexical_cast<std::string>(other.m_elements_in_bin)
+                                                 + ALPS_STACKTRACE);
+                    rebin_to(bin_size);
+                    other.rebin_to(bin_size);
+                    for (storage_type::const_iterator it = other.m_observables.begin(); it != other.m_observables.end(); ++it)
+                        find_or_insert(it->first, it->second.sum.size());
+                    for (storage_type::const_iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                        other.find_or_insert(it->first, it->second.sum.size());
+
+                    m_count += other.m_count;
+                    m_elements_in_partial += other.m_elements_in_partial;
+                    m_sign_sum += other.m_sign_sum;
+                    m_sign_partial += other.m_sign_partial;
+                    m_sign_bins.insert(m_sign_bins.end(), other.m_sign_bins.begin(), other.m_sign_bins.end());
+                    for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it) {
+                        series & obs = it->second;
+                        series const & rhs_obs = other.m_observables.find(it->first)->second;
+                        for (std::size_t i = 0; i < obs.sum.size(); ++i) {
+                            obs.sum[i] += rhs_obs.sum[i];
+                            obs.partial[i] += rhs_obs.partial[i];
+                        }
+                        obs.bins.insert(obs.bins.end(), rhs_obs.bins.begin(), rhs_obs.bins.end());
+                    }
+                    normalize();
+                }
+
+                void save(hdf5::archive & ar) const {
+                    ar.create_group("");
+                    ar["max_bin_number"] = static_cast<count_type>(m_max_bin_number);
+                    ar["count"] = m_count;
+                    ar["bin_size"] = m_elements_in_bin;
+                    ar["partial_count"] = m_elements_in_partial;
+                    ar["sign/sum"] = m_sign_sum;
+                    ar["sign/partial"] = m_sign_partial;
+                    if (!m_sign_bins.empty())
+                        ar["sign/bins"] = m_sign_bins;
+                    for (storage_type::const_iterator it = m_observables.begin(); it != m_observables.end(); ++it) {
+                        std::string const path = "observables/" + it->first;
+                        ar[path + "/sum"] = it->second.sum;
+                        ar[path + "/partial"] = it->second.partial;
+                        if (!it->second.bins.empty())
+                            ar[path + "/bins"] = it->second.bins;
+                    }
+                }
+
+                /// Loads the set; the current sample ends
+                void load(hdf5::archive & ar) {
+                    reset();
+                    count_type max_bin_number;
+                    ar["max_bin_number"] >> max_bin_number;
+                    m_max_bin_number = max_bin_number;
+                    ar["count"] >> m_count;
+                    ar["bin_size"] >> m_elements_in_bin;
+                    ar["partial_count"] >> m_elements_in_partial;
+                    ar["sign/sum"] >> m_sign_sum;
+                    ar["sign/partial"] >> m_sign_partial;
+                    if (ar.is_data("sign/bins"))
+                        ar["sign/bins"] >> m_sign_bins;
+                    if (!ar.is_group("observables"))
+                        return;
+                    std::vector<std::string> const children = ar.list_children("observables");
+                    for (std::vector<std::string>::const_iterator it = children.begin(); it != children.end(); ++it) {
+                        std::string const path = "observables/" + *it;
+                        series & obs = m_observables[*it];
+                        ar[path + "/sum"] >> obs.sum;
+                        ar[path + "/partial"] >> obs.partial;
+                        if (ar.is_data(path + "/bins"))
+                            ar[path + "/bins"] >> obs.bins;
+                        if (obs.partial.size() != obs.sum.size() || obs.bins.size() != m_sign_bins.size() * obs.sum.size())
+                            throw std::runtime_error("Inconsistent sizes of the observable " + *it + " in the archive" + ALPS_STACKTRACE);
+                    }
+                }
+
+#ifdef ALPS_HAVE_MPI
+                /// Collective MPI merge of the sets of all processes into the set of the process `root`
+                /** All processes must have measured the same observables. The sets of the
+                    other processes are left unchanged. The current sample ends. */
+                void collective_merge(alps::mpi::communicator const & comm, int root) {
+                    static std::size_t const largest = std::numeric_limits<std::size_t>::max();
+                    m_in_sample = false;
+                    alps::alps_mpi::packed_reduction buffer(comm.rank());
+
+                    // pass 1: the common bin size, and the number and lengths of the observables,
+                    // as their largest and (by `largest - size`) smallest values
+                    buffer.add_shape(m_elements_in_bin);
+                    buffer.add_shape(m_observables.size());
+                    buffer.add_shape(largest - m_observables.size());
+                    for (storage_type::const_iterator it = m_observables.begin(); it != m_observables.end(); ++it) {
+                        buffer.add_shape(it->second.sum.size());
+                        buffer.add_shape(largest - it->second.sum.size());
+                    }
+                    buffer.reduce_shape(comm);
+
+                    // pass 2: the number of local bins at the common bin size
+                    buffer.rewind();
+                    count_type const bin_size = buffer.shape();
+                    if (!same_on_all(buffer))
+                        throw std::runtime_error("Different observables were measured on the MPI processes." + ALPS_STACKTRACE);
+                    for (storage_type::const_iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                        if (!same_on_all(buffer))
+                            throw std::runtime_error(it->first + " has different lengths on the MPI processes." + ALPS_STACKTRACE);
+                    ratio_accumulator_set local(*this);
+                    local.rebin_to(bin_size);
+                    buffer.add_gather(local.m_sign_bins.size());
+                    buffer.gather(comm);
+
+                    // pass 3: the sums, and the local bins at their place among the bins of all processes
+                    std::vector<std::size_t> const index(buffer.gathered());
+                    std::size_t const offset = std::accumulate(index.begin(), index.begin() + comm.rank(), std::size_t(0));
+                    std::size_t const total_bins = std::accumulate(index.begin(), index.end(), std::size_t(0));
+                    buffer.pack_count(local.m_count);
+                    buffer.pack_count(local.m_elements_in_partial);
+                    buffer.pack(local.m_sign_sum);
+                    buffer.pack(local.m_sign_partial);
+                    buffer.pack(place_bins(local.m_sign_bins, 1, offset, total_bins));
+                    for (storage_type::const_iterator it = local.m_observables.begin(); it != local.m_observables.end(); ++it) {
+                        buffer.pack(it->second.sum);
+                        buffer.pack(it->second.partial);
+                        buffer.pack(place_bins(it->second.bins, it->second.sum.size(), offset, total_bins));
+                    }
+                    buffer.reduce(comm, root);
+                    if (comm.rank() != root)
+                        return;
+
+                    buffer.rewind();
+                    m_count = buffer.unpack_count();
+                    m_elements_in_partial = buffer.unpack_count();
+                    m_elements_in_bin = bin_size;
+                    buffer.unpack(m_sign_sum);
+                    buffer.unpack(m_sign_partial);
+                    m_sign_bins.resize(total_bins);
+                    buffer.unpack(m_sign_bins);
+                    for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it) {
+                        buffer.unpack(it->second.sum);
+                        buffer.unpack(it->second.partial);
+                        it->second.bins.resize(total_bins * it->second.sum.size());
+                        buffer.unpack(it->second.bins);
+                    }
+                    normalize();
+                }
+#endif
+
+            private:
+                /// Sums of s·O of one observable: over all samples, in the partial bin and in the complete bins
+                struct series {
+                    std::vector<double> sum;
+                    std::vector<double> partial;
+                    /// `bin_number()` bins of `sum.size()` elements each, one after the other
+                    std::vector<double> bins;
+                };
+                typedef std::map<std::string, series> storage_type;
+
+                series & find_or_insert(std::string const & name, std::size_t size) {
+                    storage_type::iterator it = m_observables.find(name);
+                    if (it == m_observables.end()) {
+                        // the earlier samples count as zero
+                        series & obs = m_observables[name];
+                        obs.sum.assign(size, 0.);
+                        obs.partial.assign(size, 0.);
+                        obs.bins.assign(m_sign_bins.size() * size, 0.);
+                        return obs;
+                    }
+                    if (it->second.sum.size() != size)
+                        throw std::runtime_error("The observable " + name + " has " + boost::lexical_cast<std::string>(it->second.sum.size())
+                                                 + " elements, not " + boost::lexical_cast<std::string>(size) + ALPS_STACKTRACE);
+                    return it->second;
+                }
+
+                /// Closes the bins filled by the partial bin, and halves the number of bins while there are too many
+                void normalize() {
+                    while (true) {
+                        if (m_sign_bins.size() > m_max_bin_number) {
+                            if (m_sign_bins.size() % 2 == 1)
+                                move_last_bin_to_partial();
+                            halve(m_sign_bins, 1);
+                            for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                                halve(it->second.bins, it->second.sum.size());
+                            m_elements_in_bin *= 2;
+                        } else if (m_elements_in_partial >= m_elements_in_bin) {
+                            // the new bin takes exactly one bin's worth of the samples of the partial bin
+                            double const fraction = static_cast<double>(m_elements_in_bin) / m_elements_in_partial;
+                            m_elements_in_partial -= m_elements_in_bin;
+                            close_bin(m_sign_bins, &m_sign_partial, 1, fraction);
+                            for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                                close_bin(it->second.bins, &it->second.partial.front(), it->second.sum.size(), fraction);
+                        } else
+                            break;
+                    }
+                }
+
+                /// Moves `fraction` of the partial bin of `size` elements to a new bin
+                void close_bin(std::vector<double> & bins, double * partial, std::size_t size, double fraction) const {
+                    for (std::size_t i = 0; i < size; ++i) {
+                        double const value = partial[i] * fraction;
+                        bins.push_back(value);
+                        partial[i] = m_elements_in_partial ? partial[i] - value : 0.;
+                    }
+                }
+
+                void move_last_bin_to_partial() {
+                    m_elements_in_partial += m_elements_in_bin;
+                    m_sign_partial += m_sign_bins.back();
+                    m_sign_bins.pop_back();
+                    for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it) {
+                        series & obs = it->second;
+                        std::size_t const size = obs.sum.size();
+                        for (std::size_t i = 0; i < size; ++i)
+                            obs.partial[i] += obs.bins[obs.bins.size() - size + i];
+                        obs.bins.resize(obs.bins.size() - size);
+                    }
+                }
+
+                /// Sums the pairs of consecutive bins of `size` elements
+                static void halve(std::vector<double> & bins, std::size_t size) {
+                    std::size_t const pairs = bins.size() / size / 2;
+                    for (std::size_t j = 0; j < pairs; ++j)
+                        for (std::size_t i = 0; i < size; ++i)
+                            bins[j * size + i] = bins[2 * j * size + i] + bins[(2 * j + 1) * size + i];
+                    bins.resize(pairs * size);
+                }
+
+                /// Sums the bins into bins of `new_elements_in_bin` samples; the bins left over go to the partial bin
+                void rebin_to(count_type new_elements_in_bin) {
+                    while (m_elements_in_bin < new_elements_in_bin) {
+                        if (m_sign_bins.size() % 2 == 1)
+                            move_last_bin_to_partial();
+                        halve(m_sign_bins, 1);
+                        for (storage_type::iterator it = m_observables.begin(); it != m_observables.end(); ++it)
+                            halve(it->second.bins, it->second.sum.size());
+                        m_elements_in_bin *= 2;
+                    }
+                }
+
+                /// The complete bins, and the partial bin if it holds a full bin of samples
+                std::vector<double> complete_bins(std::vector<double> const & bins, std::vector<double> const & partial) const {
+                    std::vector<double> result(bins);
+                    if (m_elements_in_partial == m_elements_in_bin)
+                        result.insert(result.end(), partial.begin(), partial.end());
+                    return result;
+                }
+
+                /// Jackknife error of the ratios of the sums of the bins `numerator` (of `size` elements) and `denominator`
+                static std::vector<double> jackknife_error(std::vector<double> const & numerator, std::size_t size, std::vector<double> const & denominator) {
+                    std::size_t const nbins = denominator.size();
+                    if (nbins < 2)
+                        return std::vector<double>(size, std::numeric_limits<double>::infinity());
+                    double const denominator_sum = std::accumulate(denominator.begin(), denominator.end(), 0.);
+                    std::vector<double> error(size);
+                    std::vector<double> jackknife(nbins);
+                    for (std::size_t i = 0; i < size; ++i) {
+                        double numerator_sum = 0.;
+                        for (std::size_t k = 0; k < nbins; ++k)
+                            numerator_sum += numerator[k * size + i];
+                        double jackknife_mean = 0.;
+                        for (std::size_t k = 0; k < nbins; ++k) {
+                            jackknife[k] = (numerator_sum - numerator[k * size + i]) / (denominator_sum - denominator[k]);
+                            jackknife_mean += jackknife[k];
+                        }
+                        jackknife_mean /= nbins;
+                        double variance = 0.;
+                        for (std::size_t k = 0; k < nbins; ++k)
+                            variance += (jackknife[k] - jackknife_mean) * (jackknife[k] - jackknife_mean);
+                        error[i] = std::sqrt(variance * (nbins - 1) / nbins);
+                    }
+                    return error;
+                }
+
+#ifdef ALPS_HAVE_MPI
+                /// Whether the next shape, added as `size` and `largest - size`, has the same size on all processes
+                static bool same_on_all(alps::alps_mpi::packed_reduction & buffer) {
+                    std::size_t const maximum = buffer.shape();
+                    std::size_t const minimum = std::numeric_limits<std::size_t>::max() - buffer.shape();
+                    return maximum == minimum;
+                }
+
+                /// The bins of `size` elements at position `offset` among `total_bins` zero bins
+                static std::vector<double> place_bins(std::vector<double> const & bins, std::size_t size, std::size_t offset, std::size_t total_bins) {
+                    std::vector<double> result(total_bins * size, 0.);
+                    std::copy(bins.begin(), bins.end(), result.begin() + offset * size);
+                    return result;
+                }
+#endif
+
+                std::size_t m_max_bin_number;
+                count_type m_count;
+                count_type m_elements_in_bin;
+                count_type m_elements_in_partial;
+                /// Sign of the current sample, valid if `m_in_sample`
+                double m_sign;
+                bool m_in_sample;
+                double m_sign_sum;
+                double m_sign_partial;
+                std::vector<double> m_sign_bins;
+                storage_type m_observables;
+        };
+
+    }
+}
+
+ #endif
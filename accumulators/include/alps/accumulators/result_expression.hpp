@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file result_expression.hpp defines deferred arithmetic on results */
+
+#ifndef ALPS_ACCUMULATOR_RESULT_EXPRESSION_HPP
+#define ALPS_ACCUMULATOR_RESULT_EXPRESSION_HPP
+
+#include <alps/config.hpp>
+#include <alps/accumulators/accumulator.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <utility>
+
+namespace alps {
+    namespace accumulators {
+
+        namespace detail {
+            struct expression_node;
+        }
+
+        /// An arithmetic expression of results, evaluated when it is converted to a `result_wrapper`
+        /** The arithmetic operators of `result_wrapper` evaluate every operation
+            at once: each of them copies its operands, and for full binning results
+            transforms all bins and jackknife bins. An expression started by `lazy()`
+            only records the operations, which are evaluated together by `evaluate()`.
+
+            If all results in the expression are full binning results of the same
+            scalar type, the bins and the jackknife bins of the expression are
+            computed directly from those of the operands: each operation is applied
+            in place to a vector of bins, without intermediate results or copies
+            of the operands. The jackknife bins of the operands are generated once
+            and kept in the operands, so that further expressions of the same
+            results reuse them. The mean, error and bins are the same as those
+            obtained with the operators of `result_wrapper`; the binning analysis
+            (e.g., the autocorrelation) of the expression propagates the plain
+            means of the operands rather than their jackknife estimates.
+            Other expressions are evaluated operation by operation.
+
+            The results in the expression are referred to, not copied (except for
+            temporaries); they must outlive the expression.
+
+            Example:
+            @code
+                const result_wrapper & mag2 = results["Magnetization^2"];
+                const result_wrapper & mag4 = results["Magnetization^4"];
+                result_wrapper binder = 1 - lazy(mag4) / (3 * lazy(mag2) * lazy(mag2));
+            @endcode
+        */
+        class result_expression {
+            public:
+                /// The expression consisting of the result `arg`, which must outlive the expression
+                explicit result_expression(result_wrapper const & arg);
+                /// The expression consisting of a copy of the temporary result `arg`
+                explicit result_expression(result_wrapper && arg);
+
+                /// Evaluates the expression
+                result_wrapper evaluate() const;
+                operator result_wrapper() const { return evaluate(); }
+
+                result_expression operator+() const { return *this; }
+                result_expression operator-() const;
+                result_expression inverse() const;
+
+                result_expression sin() const;
+                result_expression cos() const;
+                result_expression tan() const;
+                result_expression sinh() const;
+                result_expression cosh() const;
+                result_expression tanh() const;
+                result_expression asin() const;
+                result_expression acos() const;
+                result_expression atan() const;
+                result_expression abs() const;
+                result_expression sqrt() const;
+                result_expression log() const;
+                result_expression sq() const;
+                result_expression cb() const;
+                result_expression cbrt() const;
+
+                typedef boost::shared_ptr<detail::expression_node const> node_pointer;
+
+                explicit result_expression(node_pointer const & node): m_node(node) {}
+
+                node_pointer const & node() const { return m_node; }
+
+            private:
+                node_pointer m_node;
+        };
+
+        /// Starts an expression of the result `arg`, which must outlive the expression
+        inline result_expression lazy(result_wrapper const & arg) { return result_expression(arg); }
+        /// Starts an expression of a copy of the temporary result `arg`
+        inline result_expression lazy(result_wrapper && arg) { return result_expression(std::move(arg)); }
+
+        #define ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(OPNAME)                                          \
+            result_expression OPNAME (result_expression const & lhs, result_expression const & rhs); \
+            result_expression OPNAME (result_expression const & lhs, result_wrapper const & rhs);    \
+            result_expression OPNAME (result_expression const & lhs, result_wrapper && rhs);         \
+            result_expression OPNAME (result_wrapper const & lhs, result_expression const & rhs);    \
+            result_expression OPNAME (result_wrapper && lhs, result_expression const & rhs);         \
+            result_expression OPNAME (result_expression const & lhs, long double rhs);               \
+            result_expression OPNAME (long double lhs, result_expression const & rhs);
+
+            ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator+)
+            ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator-)
+            ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator*)
+            ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator/)
+
+        #undef ALPS_ACCUMULATOR_EXPRESSION_OPERATOR
+
+        #define ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(FUN)                       \
+            inline result_expression FUN (result_expression const & arg) {      \
+                return arg. FUN ();                                             \
+            }
+
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sin)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cos)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(tan)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sinh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cosh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(tanh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(asin)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(acos)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(atan)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(abs)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sqrt)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(log)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sq)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cb)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cbrt)
+
+        #undef ALPS_ACCUMULATOR_EXPRESSION_FUNCTION
+    }
+}
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file sample_adapter.hpp
+    @brief Conversion of samples of other types (e.g., Eigen vectors) to the value types of the accumulators
+*/
+
+#ifndef ALPS_ACCUMULATOR_SAMPLE_ADAPTER_HPP
+#define ALPS_ACCUMULATOR_SAMPLE_ADAPTER_HPP
+
+#include <boost/type_traits/is_base_of.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <Eigen/Core>
+
+#include <vector>
+
+namespace alps {
+    namespace accumulators {
+        namespace detail {
+
+            /// Converts a sample to the value type of the accumulator it is added to
+            /** The generic version passes the sample on unchanged. */
+            template<typename T, typename Enable = void> struct sample_adapter {
+                typedef T type;
+                static T const & convert(T const & value) { return value; }
+            };
+
+            /// Converts an Eigen dense vector, array or expression to a `std::vector` of its scalar type
+            /** Eigen types are not value types of the accumulators: the sample is copied
+                once, by evaluating it directly into a buffer which is kept per thread (and
+                per sample type). Adding a sample thus does not allocate once the buffer
+                has reached the size of the samples. Two-dimensional samples are
+                flattened in column-major order. The scalar type must match the value type
+                of the accumulator, e.g. `Eigen::VectorXd` for `std::vector<double>`.
+                The returned reference is valid until the next conversion on the thread. */
+            template<typename T>
+            struct sample_adapter<T, typename boost::enable_if<boost::is_base_of<Eigen::DenseBase<T>, T> >::type> {
+                typedef typename T::Scalar scalar_type;
+                typedef std::vector<scalar_type> type;
+
+                static type const & convert(T const & value) {
+                    static thread_local type buffer;
+                    buffer.resize(value.size());
+                    if (!buffer.empty())
+                        Eigen::Map<Eigen::Array<scalar_type, Eigen::Dynamic, Eigen::Dynamic> >(&buffer[0], value.rows(), value.cols()) = value.derived().array();
+                    return buffer;
+                }
+            };
+
+        }
+    }
+}
+
+#endif // ALPS_ACCUMULATOR_SAMPLE_ADAPTER_HPP
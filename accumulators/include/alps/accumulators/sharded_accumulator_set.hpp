@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file sharded_accumulator_set.hpp defines a set of accumulators recorded into by several threads */
+
+#ifndef ALPS_ACCUMULATOR_SHARDED_ACCUMULATOR_SET_HPP
+#define ALPS_ACCUMULATOR_SHARDED_ACCUMULATOR_SET_HPP
+
+#include <alps/config.hpp>
+#include <alps/accumulators/accumulator.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+namespace alps {
+    namespace accumulators {
+
+        /// A set of accumulators with one independent copy ("shard") per worker thread
+        /** Every shard is an ordinary `accumulator_set` holding a clone of each
+            accumulator of the prototype set; the clones start empty, so samples
+            already in the prototype are not counted by `reduce()`. A thread records only into its own
+            shard, so no locks or atomics are needed on the hot path; handles
+            obtained by `shard(i).handle<A>(name)` work as usual.
+
+            `reduce()` merges the shards in the order of their indices, so the
+            result does not depend on the scheduling of the threads. The shards
+            must not be modified while they are reduced.
+
+            Example:
+            @code
+                accumulator_set prototype;
+                prototype << FullBinningAccumulator<double>("Energy");
+                sharded_accumulator_set shards(prototype, nthreads);
+                // in thread i:
+                shards.shard(i)["Energy"] << -0.5;
+                // after joining the threads:
+                accumulator_set measurements;
+                shards.reduce(measurements);
+            @endcode
+        */
+        class sharded_accumulator_set {
+            public:
+                /// Creates `nshards` shards, each holding empty clones of the accumulators of `prototype`
+                sharded_accumulator_set(accumulator_set const & prototype, std::size_t nshards)
+                    : m_shards(nshards)
+                {
+                    if (nshards == 0)
+                        throw std::invalid_argument("A sharded accumulator set needs at least one shard" + ALPS_STACKTRACE);
+                    for (std::size_t i = 0; i < nshards; ++i) {
+                        // each shard is allocated separately, so that threads do not write to shared cache lines
+                        m_shards[i].reset(new accumulator_set());
+                        clone_into(*m_shards[i], prototype);
+                        m_shards[i]->reset();
+                    }
+                }
+
+                /// Number of shards
+                std::size_t size() const { return m_shards.size(); }
+
+                /// The shard recorded into by thread `i`
+                accumulator_set & shard(std::size_t i) { return *m_shards.at(i); }
+                accumulator_set const & shard(std::size_t i) const { return *m_shards.at(i); }
+
+                /// Replaces the content of `target` by the merge of all shards, in shard order
+                /** Shards into which no value was recorded for an observable are skipped for it. */
+                void reduce(accumulator_set & target) const {
+                    target.clear();
+                    clone_into(target, *m_shards[0]);
+                    for (std::size_t i = 1; i < m_shards.size(); ++i) {
+                        for (accumulator_set::const_iterator it = m_shards[i]->begin(); it != m_shards[i]->end(); ++it) {
+                            if (it->second->count() == 0)
+                                continue;
+                            accumulator_wrapper & acc = target[it->first];
+                            if (acc.count() == 0)
+                                acc = it->second->clone();
+                            else
+                                acc.merge(*(it->second));
+                        }
+                    }
+                }
+
+                /// Resets the accumulators in all shards
+                void reset() {
+                    for (std::size_t i = 0; i < m_shards.size(); ++i)
+                        m_shards[i]->reset();
+                }
+
+            private:
+                static void clone_into(accumulator_set & target, accumulator_set const & source) {
+                    for (accumulator_set::const_iterator it = source.begin(); it != source.end(); ++it)
+                        target.insert(it->first, boost::shared_ptr<accumulator_wrapper>(it->second->new_clone()));
+                }
+
+                std::vector<boost::shared_ptr<accumulator_set> > m_shards;
+        };
+
+    }
+}
+
+#endif
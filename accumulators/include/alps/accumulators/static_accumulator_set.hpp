@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file static_accumulator_set.hpp defines a set of accumulators whose types are known at compile time */
+
+#ifndef ALPS_ACCUMULATOR_STATIC_ACCUMULATOR_SET_HPP
+#define ALPS_ACCUMULATOR_STATIC_ACCUMULATOR_SET_HPP
+
+#include <alps/config.hpp>
+#include <alps/hdf5/archive.hpp>
+#include <alps/accumulators/accumulator.hpp>
+#include <alps/accumulators/namedaccumulators.hpp>
+
+#include <boost/shared_ptr.hpp>
+
+#include <array>
+#include <tuple>
+#include <string>
+#include <stdexcept>
+#include <typeinfo>
+#include <type_traits>
+
+namespace alps {
+    namespace accumulators {
+
+        /// A set of accumulators of the named accumulator types A... (e.g. `FullBinningAccumulator<double>`)
+        /** The accumulators are stored by value and accessed by their position,
+            `get<I>()`, which returns the accumulator itself: adding a value
+            compiles down to the feature chain of the accumulator, without a
+            name lookup, a variant visitation or a virtual call.
+
+            The set is saved and loaded with the same HDF5 layout as an
+            `accumulator_set` holding the same accumulators, so that either
+            can read the archive written by the other. `insert_results()` and
+            `insert_accumulators()` convert it to the dynamic sets.
+
+            Example:
+            @code
+                static_accumulator_set< FullBinningAccumulator<double>, MeanAccumulator<double> >
+                    measurements(FullBinningAccumulator<double>("Energy"), MeanAccumulator<double>("Sign"));
+                measurements.get<0>()(-0.5);
+                measurements.get<1>()(1.);
+                result_set results;
+                measurements.insert_results(results);
+            @endcode
+        */
+        template<typename... A> class static_accumulator_set {
+            public:
+                typedef std::tuple<typename A::accumulator_type...> storage_type;
+
+                /// Type of the `I`-th accumulator
+                template<std::size_t I> struct accumulator_type {
+                    typedef typename std::tuple_element<I, storage_type>::type type;
+                };
+
+                /// Number of accumulators in the set
+                static constexpr std::size_t size() { return sizeof...(A); }
+
+                /// Constructs the set from named accumulators, copying their names and parameters
+                explicit static_accumulator_set(A const &... named)
+                    : m_names{{ named.name... }}
+                    , m_accumulators(named.wrapper->template extract<typename A::accumulator_type>()...)
+                {}
+
+                /// The `I`-th accumulator
+                template<std::size_t I> typename accumulator_type<I>::type & get() {
+                    return std::get<I>(m_accumulators);
+                }
+                template<std::size_t I> typename accumulator_type<I>::type const & get() const {
+                    return std::get<I>(m_accumulators);
+                }
+
+                /// Name of the `i`-th accumulator
+                std::string const & name(std::size_t i) const { return m_names.at(i); }
+
+                /// Position of the accumulator `name`
+                std::size_t index(std::string const & name) const {
+                    for (std::size_t i = 0; i < m_names.size(); ++i)
+                        if (m_names[i] == name)
+                            return i;
+                    throw std::out_of_range("No observable found with the name: " + name + ALPS_STACKTRACE);
+                }
+
+                void reset() {
+                    reset_visitor visitor;
+                    for_each(m_accumulators, visitor);
+                }
+
+                /// Merge another set of the same type into this one. @param rhs the set to merge.
+                void merge(static_accumulator_set const & rhs) {
+                    merge_visitor visitor(rhs);
+                    for_each(m_accumulators, visitor);
+                }
+
+                void save(hdf5::archive & ar) const {
+                    ar.create_group("");
+                    save_visitor visitor(ar);
+                    for_each(m_accumulators, visitor);
+                }
+
+                /// Loads the accumulators; an accumulator absent from the archive is reset
+                void load(hdf5::archive & ar) {
+                    load_visitor visitor(ar);
+                    for_each(m_accumulators, visitor);
+                }
+
+                /// Inserts the results of all accumulators into `results`
+                void insert_results(result_set & results) const {
+                    insert_results_visitor visitor(results);
+                    for_each(m_accumulators, visitor);
+                }
+
+                /// Inserts copies of all accumulators into `accumulators`
+                void insert_accumulators(accumulator_set & accumulators) const {
+                    insert_accumulators_visitor visitor(accumulators);
+                    for_each(m_accumulators, visitor);
+                }
+
+#ifdef ALPS_HAVE_MPI
+                /// Collective MPI merge of all accumulators, in the order of the set
+                void collective_merge(alps::mpi::communicator const & comm, int root) {
+                    collective_merge_visitor visitor(comm, root);
+                    for_each(m_accumulators, visitor);
+                }
+#endif
+
+            private:
+                typedef std::integral_constant<std::size_t, sizeof...(A)> end_index;
+
+                /// Calls `f(accumulator, name, index)` for all accumulators, in the order of the set
+                template<typename S, typename F> void for_each(S & accumulators, F & f) const {
+                    for_each(accumulators, f, std::integral_constant<std::size_t, 0>());
+                }
+                template<typename S, typename F> void for_each(S &, F &, end_index) const {}
+                template<typename S, typename F, std::size_t I> void for_each(S & accumulators, F & f, std::integral_constant<std::size_t, I>) const {
+                    f(std::get<I>(accumulators), m_names[I], std::integral_constant<std::size_t, I>());
+                    for_each(accumulators, f, std::integral_constant<std::size_t, I + 1>());
+                }
+
+                struct reset_visitor {
+                    template<typename T, typename I> void operator()(T & acc, std::string const &, I) const {
+                        acc.reset();
+                    }
+                };
+
+                struct merge_visitor {
+                    merge_visitor(static_accumulator_set const & r): rhs(r) {}
+                    template<typename T, typename I> void operator()(T & acc, std::string const &, I) const {
+                        acc.merge(std::get<I::value>(rhs.m_accumulators));
+                    }
+                    static_accumulator_set const & rhs;
+                };
+
+                struct save_visitor {
+                    save_visitor(hdf5::archive & a): ar(a) {}
+                    template<typename T, typename I> void operator()(T const & acc, std::string const & name, I) const {
+                        // empty accumulators are skipped, as by accumulator_set::save
+                        if (acc.count() != 0)
+                            ar[name] = acc;
+                    }
+                    hdf5::archive & ar;
+                };
+
+                struct load_visitor {
+                    load_visitor(hdf5::archive & a): ar(a) {}
+                    template<typename T, typename I> void operator()(T & acc, std::string const & name, I) const {
+                        if (!ar.is_group(name)) {
+                            acc.reset();
+                            return;
+                        }
+                        ar.set_context(name);
+                        if (!T::can_load(ar))
+                            throw std::logic_error("The Accumulator " + name + " cannot be unserialized into a " + typeid(T).name() + ALPS_STACKTRACE);
+                        ar[""] >> acc;
+                        ar.set_context("..");
+                    }
+                    hdf5::archive & ar;
+                };
+
+                struct insert_results_visitor {
+                    insert_results_visitor(result_set & r): results(r) {}
+                    template<typename T, typename I> void operator()(T const & acc, std::string const & name, I) const {
+                        results.insert(name, boost::shared_ptr<result_wrapper>(new result_wrapper(typename T::result_type(acc))));
+                    }
+                    result_set & results;
+                };
+
+                struct insert_accumulators_visitor {
+                    insert_accumulators_visitor(accumulator_set & a): accumulators(a) {}
+                    template<typename T, typename I> void operator()(T const & acc, std::string const & name, I) const {
+                        accumulators.insert(name, boost::shared_ptr<accumulator_wrapper>(new accumulator_wrapper(acc)));
+                    }
+                    accumulator_set & accumulators;
+                };
+
+#ifdef ALPS_HAVE_MPI
+                struct collective_merge_visitor {
+                    collective_merge_visitor(alps::mpi::communicator const & c, int r): comm(c), root(r) {}
+                    template<typename T, typename I> void operator()(T & acc, std::string const &, I) const {
+                        acc.collective_merge(comm, root);
+                    }
+                    alps::mpi::communicator const & comm;
+                    int root;
+                };
+#endif
+
+                std::array<std::string, sizeof...(A)> m_names;
+                storage_type m_accumulators;
+        };
+
+    }
+}
+
+#endif
@@ -0,0 +1,361 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file timeseries_spill.hpp
+    @brief Streaming of the full time series of an accumulator to an HDF5 file
+*/
+
+#ifndef ALPS_ACCUMULATOR_TIMESERIES_SPILL_HPP
+#define ALPS_ACCUMULATOR_TIMESERIES_SPILL_HPP
+
+#include <alps/config.hpp>
+#include <alps/hdf5/archive.hpp>
+#include <alps/hdf5/vector.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#ifdef ALPS_HAVE_MPI
+    #include <alps/utilities/mpi.hpp>
+#endif
+
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/utility/enable_if.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace alps {
+    namespace accumulators {
+        namespace detail {
+
+            /// Access to the elements of a sample as a contiguous array of scalars
+            /** The generic version is for types which cannot be spilled. */
+            template<typename T, typename Enable = void> struct spill_traits {
+                static const bool supported = false;
+            };
+
+            template<typename T> struct spill_traits<T, typename boost::enable_if<boost::is_arithmetic<T> >::type> {
+                typedef T scalar_type;
+                static const bool supported = true;
+                static const bool is_vector = false;
+                static std::size_t size(T const &) { return 1; }
+                static scalar_type const * data(T const & value) { return &value; }
+            };
+
+            template<typename T> struct spill_traits<std::vector<T>, typename boost::enable_if<boost::is_arithmetic<T> >::type> {
+                typedef T scalar_type;
+                static const bool supported = true;
+                static const bool is_vector = true;
+                static std::size_t size(std::vector<T> const & value) { return value.size(); }
+                static scalar_type const * data(std::vector<T> const & value) { return value.empty() ? 0 : &value[0]; }
+            };
+
+            /// Datasets of spill files which are written by a stream of this process
+            /** Each stream claims its own dataset when it first writes to the file, so that copies
+                of an accumulator (e.g., the shards of a `sharded_accumulator_set`) never write the
+                same dataset. */
+            class spill_datasets {
+                typedef std::map<std::string, std::set<std::string> > map_type;
+
+              public:
+                /// Claims the dataset `name` of `file`; if it is taken, the first free of `name.1`, `name.2`, ...
+                /** If `exact`, throws instead of falling back to another dataset. */
+                static std::string claim(std::string const & file, std::string const & name, bool exact) {
+                    std::lock_guard<std::mutex> guard(mutex());
+                    std::set<std::string> & taken = claimed()[file];
+                    std::string result = name;
+                    for (std::size_t i = 1; taken.count(result); ++i) {
+                        if (exact)
+                            throw std::runtime_error("The dataset " + name + " of " + file
+                                                     + " is already written by another accumulator" + ALPS_STACKTRACE);
+                        result = name + "." + boost::lexical_cast<std::string>(i);
+                    }
+                    taken.insert(result);
+                    return result;
+                }
+
+                static void release(std::string const & file, std::string const & name) {
+                    std::lock_guard<std::mutex> guard(mutex());
+                    map_type::iterator it = claimed().find(file);
+                    if (it == claimed().end())
+                        return;
+                    it->second.erase(name);
+                    if (it->second.empty())
+                        claimed().erase(it);
+                }
+
+              private:
+                static std::mutex & mutex() {
+                    static std::mutex instance;
+                    return instance;
+                }
+                static map_type & claimed() {
+                    static map_type instance;
+                    return instance;
+                }
+            };
+
+            /// The spill file written by this process
+            /** Processes must not write to the same HDF5 file. If MPI runs with several
+                processes, the rank is inserted before the extension: `run.h5` -> `run.3.h5`. */
+            inline std::string spill_file_of_process(std::string const & file) {
+#ifdef ALPS_HAVE_MPI
+                if (alps::mpi::environment::initialized() && !alps::mpi::environment::finalized()) {
+                    int size, rank;
+                    MPI_Comm_size(MPI_COMM_WORLD, &size);
+                    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+                    if (size > 1) {
+                        std::string::size_type dot = file.rfind('.');
+                        std::string::size_type slash = file.rfind('/');
+                        if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+                            dot = file.size();
+                        return file.substr(0, dot) + "." + boost::lexical_cast<std::string>(rank) + file.substr(dot);
+                    }
+                }
+#endif
+                return file;
+            }
+
+            /// Streams the bins of `bin_size` consecutive samples to an appendable dataset of an HDF5 file
+            /** The completed bins are buffered and appended to the dataset
+                `/timeseries/<name>` of the file in blocks of `block_rows` bins; the
+                dataset is chunked by blocks. At most one block is kept in memory.
+                The samples of the bin in progress are kept until the bin is complete.
+
+                A stream is never shared: `clone()` creates a new stream which writes to a
+                dataset of its own (`<name>.1`, `<name>.2`, ... as claimed from `spill_datasets`),
+                and each MPI process writes its own file (see `spill_file_of_process`).
+
+                The position of the stream is part of the saved state of the accumulator.
+                The first bins appended to the dataset replace the bins beyond the position
+                of the stream; i.e., those of a previous run, those written after the
+                checkpoint from which the run continues, or those written before a `reset()`.
+            */
+            template<typename T, bool Supported = spill_traits<T>::supported> class timeseries_spill {
+                typedef spill_traits<T> traits;
+                typedef typename traits::scalar_type scalar_type;
+
+              public:
+                static const std::size_t block_rows = 64;
+
+                timeseries_spill(std::string const & file, std::string const & name, std::size_t bin_size)
+                    : m_file(file)
+                    , m_name(name)
+                    , m_exact(false)
+                    , m_bin_size(bin_size)
+                    , m_size(0)
+                    , m_rows(0)
+                    , m_in_partial(0)
+                    , m_written(0)
+                    , m_truncate(true)
+                {
+                    if (m_name.empty())
+                        throw std::invalid_argument("The time series of an unnamed accumulator cannot be spilled to a file" + ALPS_STACKTRACE);
+                    if (!m_bin_size)
+                        throw std::invalid_argument("The bins spilled to a file must have at least one sample" + ALPS_STACKTRACE);
+                }
+
+                /// Appends the buffered bins to the file, if any; errors are ignored here
+                ~timeseries_spill() {
+                    try {
+                        flush();
+                    } catch (...) {}
+                    if (!m_dataset.empty())
+                        spill_datasets::release(m_path, m_dataset);
+                }
+
+                /// A new stream to the same file, which writes the bins of its samples to a dataset of its own
+                boost::shared_ptr<timeseries_spill> clone() const {
+                    return boost::shared_ptr<timeseries_spill>(new timeseries_spill(m_file, m_name, m_bin_size));
+                }
+
+                /// Adds the sample `value` to the bin in progress
+                void operator()(T const & value) {
+                    std::size_t size = traits::size(value);
+                    if (!m_size) {
+                        m_size = size;
+                        m_buffer.assign(block_rows * m_size, scalar_type());
+                    } else if (size != m_size)
+                        throw std::runtime_error("The size of the sample (" + boost::lexical_cast<std::string>(size)
+                                                 + ") does not match the size of the spilled bins ("
+                                                 + boost::lexical_cast<std::string>(m_size) + ")" + ALPS_STACKTRACE);
+                    if (!m_size)
+                        return;
+                    scalar_type * row = &m_buffer[m_rows * m_size];
+                    scalar_type const * data = traits::data(value);
+                    if (!m_in_partial)
+                        std::copy(data, data + m_size, row);
+                    else
+                        for (std::size_t i = 0; i < m_size; ++i)
+                            row[i] += data[i];
+                    if (++m_in_partial == m_bin_size) {
+                        const scalar_type bin_size = m_bin_size;
+                        for (std::size_t i = 0; i < m_size; ++i)
+                            row[i] /= bin_size;
+                        m_in_partial = 0;
+                        if (++m_rows == block_rows)
+                            flush();
+                    }
+                }
+
+                /// Appends the completed bins to the file
+                void flush() {
+                    if (!m_rows)
+                        return;
+                    if (m_dataset.empty()) {
+                        m_path = spill_file_of_process(m_file);
+                        m_dataset = spill_datasets::claim(m_path, m_preferred.empty() ? m_name : m_preferred, m_exact);
+                    }
+                    alps::hdf5::archive ar(m_path, "a");
+                    std::string path = "/timeseries/" + ar.encode_segment(m_dataset);
+                    if (m_truncate)
+                        truncate(ar, path);
+                    ar.append(path, &m_buffer[0], extent(m_rows), extent(block_rows));
+                    m_written += m_rows;
+                    if (m_in_partial)
+                        std::copy(m_buffer.begin() + m_rows * m_size, m_buffer.begin() + (m_rows + 1) * m_size, m_buffer.begin());
+                    m_rows = 0;
+                }
+
+                /// Discards the bins of this stream; they are replaced in the file by the following bins
+                void reset() {
+                    m_rows = 0;
+                    m_in_partial = 0;
+                    m_written = 0;
+                    m_truncate = true;
+                }
+
+                /// Writes the completed bins to the file and the position of the stream to `ar`
+                void save(hdf5::archive & ar) {
+                    flush();
+                    ar["timeseries/spill/bins"] = m_written;
+                    ar["timeseries/spill/bins/@file"] = m_file;
+                    ar["timeseries/spill/bins/@name"] = m_name;
+                    ar["timeseries/spill/bins/@binsize"] = m_bin_size;
+                    if (!m_dataset.empty())
+                        ar["timeseries/spill/bins/@dataset"] = m_dataset;
+                    if (m_in_partial) {
+                        ar["timeseries/spill/partialbin"] = std::vector<scalar_type>(m_buffer.begin(), m_buffer.begin() + m_size);
+                        ar["timeseries/spill/partialbin/@count"] = m_in_partial;
+                    }
+                }
+
+                /// Continues the stream at the position saved in `ar`
+                void load(hdf5::archive & ar) {
+                    reset();
+                    ar["timeseries/spill/bins"] >> m_written;
+                    // the stream continues the dataset it wrote before
+                    if (ar.is_attribute("timeseries/spill/bins/@dataset")) {
+                        ar["timeseries/spill/bins/@dataset"] >> m_preferred;
+                        m_exact = true;
+                    }
+                    if (ar.is_data("timeseries/spill/partialbin")) {
+                        std::vector<scalar_type> partial;
+                        ar["timeseries/spill/partialbin"] >> partial;
+                        ar["timeseries/spill/partialbin/@count"] >> m_in_partial;
+                        m_size = partial.size();
+                        m_buffer.assign(block_rows * m_size, scalar_type());
+                        std::copy(partial.begin(), partial.end(), m_buffer.begin());
+                    }
+                }
+
+              private:
+
+                timeseries_spill(timeseries_spill const &);
+                timeseries_spill & operator=(timeseries_spill const &);
+
+                std::vector<std::size_t> extent(std::size_t rows) const {
+                    std::vector<std::size_t> result(1, rows);
+                    if (traits::is_vector)
+                        result.push_back(m_size);
+                    return result;
+                }
+
+                /// Drops the bins beyond the `m_written` first ones from the dataset `path`
+                void truncate(hdf5::archive & ar, std::string const & path) {
+                    m_truncate = false;
+                    if (!ar.is_data(path))
+                        return;
+                    std::size_t rows = ar.extent(path)[0];
+                    if (rows < m_written)
+                        throw std::runtime_error("The file " + m_file + " holds fewer bins of " + m_name
+                                                 + " than were spilled to it" + ALPS_STACKTRACE);
+                    if (rows == m_written)
+                        return;
+                    std::vector<scalar_type> kept(m_written * m_size);
+                    if (m_written) {
+                        std::vector<std::size_t> offset(extent(m_written).size(), 0);
+                        ar.read(path, &kept[0], extent(m_written), offset);
+                    }
+                    ar.delete_data(path);
+                    if (m_written)
+                        ar.append(path, &kept[0], extent(m_written), extent(block_rows));
+                }
+
+                /// The file as configured, and the file written by this process
+                std::string m_file;
+                std::string m_path;
+                std::string m_name;
+                /// The dataset claimed at the first write, and the one to claim if not `m_name`
+                std::string m_dataset;
+                std::string m_preferred;
+                /// Whether only `m_preferred` may be claimed, since the stream continues it
+                bool m_exact;
+                std::size_t m_bin_size;
+                /// Number of scalars in a sample
+                std::size_t m_size;
+                /// Completed bins in the buffer; the bin in progress follows them
+                std::size_t m_rows;
+                std::size_t m_in_partial;
+                /// Bins appended to the file
+                std::size_t m_written;
+                /// Whether the dataset may hold bins beyond `m_written` to be dropped
+                bool m_truncate;
+                std::vector<scalar_type> m_buffer;
+            };
+
+            template<typename T, bool Supported> const std::size_t timeseries_spill<T, Supported>::block_rows;
+
+            /// The time series of other value types cannot be spilled
+            template<typename T> class timeseries_spill<T, false> {
+              public:
+                timeseries_spill(std::string const &, std::string const &, std::size_t) {
+                    throw std::logic_error("The time series of this value type cannot be spilled to a file" + ALPS_STACKTRACE);
+                }
+                boost::shared_ptr<timeseries_spill> clone() const { return boost::shared_ptr<timeseries_spill>(); }
+                void operator()(T const &) {}
+                void flush() {}
+                void reset() {}
+                void save(hdf5::archive &) {}
+                void load(hdf5::archive &) {}
+            };
+
+            /// Creates the stream saved in `ar`, if any, continuing at the saved position
+            template<typename T> boost::shared_ptr<timeseries_spill<T> > load_timeseries_spill(hdf5::archive & ar) {
+                boost::shared_ptr<timeseries_spill<T> > result;
+                if (!ar.is_data("timeseries/spill/bins"))
+                    return result;
+                std::string file, name;
+                std::size_t bin_size;
+                ar["timeseries/spill/bins/@file"] >> file;
+                ar["timeseries/spill/bins/@name"] >> name;
+                ar["timeseries/spill/bins/@binsize"] >> bin_size;
+                result.reset(new timeseries_spill<T>(file, name, bin_size));
+                result->load(ar);
+                return result;
+            }
+
+        }
+    }
+}
+
+#endif // ALPS_ACCUMULATOR_TIMESERIES_SPILL_HPP
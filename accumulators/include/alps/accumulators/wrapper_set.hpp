@@ -11,13 +11,21 @@
 #include <alps/hdf5/vector.hpp>
 #include <alps/hdf5/archive.hpp>
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
+#include <atomic>
 #include <mutex>
 
+#ifdef ALPS_HAVE_MPI
+    #include <alps/accumulators/mpi.hpp>
+#endif
+
 
 namespace alps {
     namespace accumulators {
 
+         template<typename A> class accumulator_handle;
+
          namespace detail {
 
             template<typename T> struct serializable_type {
@@ -41,6 +49,12 @@ namespace alps {
 
             void register_predefined_serializable_types();
 
+            /// A new stamp for `accumulator_wrapper::modification_stamp()`; stamps are never reused
+            inline boost::uint64_t next_modification_stamp() {
+                static std::atomic<boost::uint64_t> last(0);
+                return ++last;
+            }
+
         }
 
         namespace impl {
@@ -91,6 +105,15 @@ namespace alps {
                         return m_storage.find(name) != m_storage.end();
                     }
 
+                    /// Returns a handle to the accumulator `name` of the named accumulator type A
+                    /** The handle bypasses the lookup by name; see `accumulator_handle`. */
+                    template<typename A> accumulator_handle<A> handle(std::string const & name) {
+                        iterator it = m_storage.find(name);
+                        if (it == m_storage.end())
+                            throw std::out_of_range("No observable found with the name: " + name + ALPS_STACKTRACE);
+                        return accumulator_handle<A>(*(it->second));
+                    }
+
                     void insert(std::string const & name, boost::shared_ptr<T> ptr){
                         if (has(name))
                             throw std::out_of_range("There exists already an accumulator with the name: " + name + ALPS_STACKTRACE);
@@ -101,17 +124,47 @@ namespace alps {
                         return m_storage.size();
                     }
 
+                    /// Writes the accumulators which have samples to the group of `ar`
+                    /** If the set was last saved to the same group of the same file, only
+                        the accumulators which changed since then are written (see
+                        `accumulator_wrapper::modification_stamp()`), and the groups of the
+                        accumulators saved then but not now are deleted. While the accumulators
+                        are written, the attribute `@complete` of the group is false, so that
+                        `load()` detects a partially written checkpoint.
+                    */
                     void save(hdf5::archive & ar) const {
                         ar.create_group("");
+                        std::string const location = ar.get_filename() + ":" + ar.complete_path("");
+                        bool const incremental = (location == m_saved_location);
+                        saved_type saved;
+                        ar["@complete"] = false;
                         for(const_iterator it = begin(); it != end(); ++it) {
                             if (it->second->count()!=0) {
-                                ar[it->first] = *(it->second);
+                                saved_state const state(it->second->count(), it->second->modification_stamp());
+                                typename saved_type::const_iterator jt = m_saved.find(it->first);
+                                if (!incremental || jt == m_saved.end() || jt->second != state || !ar.is_group(it->first))
+                                    ar[it->first] = *(it->second);
+                                saved[it->first] = state;
                             }
                         }
+                        if (incremental)
+                            for (typename saved_type::const_iterator jt = m_saved.begin(); jt != m_saved.end(); ++jt)
+                                if (!saved.count(jt->first) && ar.is_group(jt->first))
+                                    ar.delete_group(jt->first);
+                        ar["@complete"] = true;
+                        m_saved.swap(saved);
+                        m_saved_location = location;
                     }
 
                     void load(hdf5::archive & ar) {
                         std::lock_guard<std::mutex> guard(m_types_mutex);
+                        if (ar.is_attribute("@complete")) {
+                            bool complete;
+                            ar["@complete"] >> complete;
+                            if (!complete)
+                                throw std::runtime_error("The accumulators in " + ar.get_filename() + ":" + ar.complete_path("")
+                                                         + " were not completely written" + ALPS_STACKTRACE);
+                        }
                         std::vector<std::string> list = ar.list_children("");
                         for (std::vector<std::string>::const_iterator it = list.begin(); it != list.end(); ++it) {
                             ar.set_context(*it);
@@ -154,6 +207,157 @@ namespace alps {
                         }
                     }
 
+#ifdef ALPS_HAVE_MPI
+                    /// Merge the sets of all processes into this set on the process `root`
+                    /** Unlike calling `collective_merge()` on every accumulator, which costs
+                        several collective operations per accumulator, the state of all
+                        accumulators is packed into a few buffers, reduced by four collective
+                        operations in total. The result is the same, up to the rounding
+                        of the sums.
+
+                        All processes must hold the same accumulators. Accumulators without
+                        measurements on all processes are left alone; an accumulator measured on
+                        only some of the processes is an error.
+                    */
+                    void collective_merge(alps::mpi::communicator const & comm, int root) {
+                        if (comm.rank() == root)
+                            packed_merge(comm, root, true);
+                        else
+                            const_cast<wrapper_set const *>(this)->collective_merge(comm, root);
+                    }
+
+                    void collective_merge(alps::mpi::communicator const & comm, int root) const {
+                        if (comm.rank() == root)
+                            throw std::runtime_error("A const object cannot be root" + ALPS_STACKTRACE);
+                        const_cast<wrapper_set *>(this)->packed_merge(comm, root, false);
+                    }
+
+#if MPI_VERSION >= 3
+                    /// A merge of the sets of all processes, started by `start_collective_merge()`
+                    /** The merge progresses only while `test()` or `wait()` is called: calling
+                        `test()` now and then between measurements lets the reduction proceed
+                        in the background. Copies of the handle refer to the same merge.
+
+                        The merge must be completed on all processes; a handle destroyed
+                        before completion waits for it.
+                    */
+                    class pending_merge {
+                        public:
+                            pending_merge(alps::mpi::communicator const & comm, int root, wrapper_set const & set)
+                                : m_state(new state(comm, root))
+                            {
+                                for (const_iterator it = set.begin(); it != set.end(); ++it)
+                                    m_state->snapshot[it->first] = boost::shared_ptr<T>(it->second->new_clone());
+                                pack_shapes(m_state->snapshot, m_state->buffer);
+                                m_state->buffer.start_reduce_shape(m_state->comm);
+                            }
+
+                            /// Lets the merge progress; returns whether it is complete
+                            bool test() {
+                                while (m_state->step != done && m_state->buffer.test())
+                                    m_state->advance();
+                                return m_state->step == done;
+                            }
+
+                            /// Blocks until the merge is complete
+                            void wait() {
+                                while (m_state->step != done) {
+                                    m_state->buffer.wait();
+                                    m_state->advance();
+                                }
+                            }
+
+                            /// Waits for the merge and replaces the content of `target` by the merged accumulators
+                            /** Only valid on the root process. */
+                            void get(wrapper_set & target) {
+                                if (m_state->comm.rank() != m_state->root)
+                                    throw std::runtime_error("The merged accumulators are only available on the root process" + ALPS_STACKTRACE);
+                                wait();
+                                target.clear();
+                                for (const_iterator it = m_state->snapshot.begin(); it != m_state->snapshot.end(); ++it)
+                                    target.insert(it->first, boost::shared_ptr<T>(it->second->new_clone()));
+                            }
+
+                        private:
+                            enum merge_step { shape_step, gather_step, reduce_step, done };
+
+                            struct state {
+                                state(alps::mpi::communicator const & c, int r)
+                                    : comm(c), root(r), step(shape_step), buffer(c.rank())
+                                {}
+
+                                ~state() {
+                                    if (step == done)
+                                        return;
+                                    // the other processes take part in the remaining collective operations
+                                    try {
+                                        while (step != done) {
+                                            buffer.wait();
+                                            advance();
+                                        }
+                                    } catch (...) {}
+                                }
+
+                                /// Completes the current step and starts the next collective operation
+                                /** If this throws, the merge is abandoned (it then throws on all processes). */
+                                void advance() {
+                                    merge_step current = step;
+                                    step = done;
+                                    switch (current) {
+                                        case shape_step:
+                                            pack_gathers(snapshot, buffer);
+                                            buffer.start_gather(comm);
+                                            step = gather_step;
+                                            break;
+                                        case gather_step:
+                                            pack_values(snapshot, buffer);
+                                            buffer.start_reduce(comm, root);
+                                            step = reduce_step;
+                                            break;
+                                        case reduce_step:
+                                            if (comm.rank() == root)
+                                                unpack_values(snapshot, buffer);
+                                            break;
+                                        case done:
+                                            break;
+                                    }
+                                }
+
+                                alps::mpi::communicator comm;
+                                int root;
+                                merge_step step;
+                                std::map<std::string, boost::shared_ptr<T> > snapshot;
+                                alps::alps_mpi::packed_reduction buffer;
+                            };
+
+                            boost::shared_ptr<state> m_state;
+                    };
+
+                    /// Starts merging the sets of all processes on the process `root`, without blocking
+                    /** The accumulators are copied when the merge starts, so that values can
+                        be added to this set while the merge proceeds; the merged copies are
+                        obtained on `root` by `pending_merge::get()`. Otherwise, the merge is
+                        the same as by `collective_merge()`.
+
+                        Example:
+                        @code
+                            accumulator_set::pending_merge merge = measurements.start_collective_merge(comm, 0);
+                            while (!merge.test())
+                                do_update_and_measure();
+                            if (comm.rank() == 0) {
+                                accumulator_set merged;
+                                merge.get(merged);
+                            }
+                        @endcode
+                    */
+                    pending_merge start_collective_merge(alps::mpi::communicator const & comm, int root) const {
+                        // the merge communicates on its own duplicate of `comm`, so that its
+                        // messages cannot be mixed up with other communication on `comm`
+                        return pending_merge(alps::mpi::communicator(comm, alps::mpi::comm_duplicate), root, *this);
+                    }
+#endif
+#endif
+
                     void print(std::ostream & os) const {
                         for(const_iterator it = begin(); it != end(); ++it)
                             os << it->first << ": " << *(it->second) << std::endl;
@@ -173,7 +377,67 @@ namespace alps {
                     void clear() { m_storage.clear(); }
 
                 private:
+#ifdef ALPS_HAVE_MPI
+                    typedef std::map<std::string, boost::shared_ptr<T> > storage_type;
+
+                    /// Packed merge; the accumulators are modified only if `is_root`
+                    void packed_merge(alps::mpi::communicator const & comm, int root, bool is_root) {
+                        alps::alps_mpi::packed_reduction buffer(comm.rank());
+                        pack_shapes(m_storage, buffer);
+                        buffer.reduce_shape(comm);
+                        pack_gathers(m_storage, buffer);
+                        buffer.gather(comm);
+                        pack_values(m_storage, buffer);
+                        buffer.reduce(comm, root);
+                        if (is_root)
+                            unpack_values(m_storage, buffer);
+                    }
+
+                    /// Pass 1 of the packed merge; starts with whether each accumulator was measured
+                    static void pack_shapes(storage_type const & storage, alps::alps_mpi::packed_reduction & buffer) {
+                        for (const_iterator it = storage.begin(); it != storage.end(); ++it) {
+                            bool has_count = it->second->count() != 0;
+                            buffer.add_shape(has_count);
+                            buffer.add_shape(!has_count);
+                            it->second->pack_shape(buffer);
+                        }
+                    }
+
+                    static void pack_gathers(storage_type const & storage, alps::alps_mpi::packed_reduction & buffer) {
+                        buffer.rewind();
+                        for (const_iterator it = storage.begin(); it != storage.end(); ++it) {
+                            bool measured_somewhere = buffer.shape(), unmeasured_somewhere = buffer.shape();
+                            if (measured_somewhere && unmeasured_somewhere)
+                                throw std::runtime_error(it->first + " was measured on only some of the MPI processes." + ALPS_STACKTRACE);
+                            it->second->pack_gather(buffer);
+                        }
+                    }
+
+                    static void pack_values(storage_type const & storage, alps::alps_mpi::packed_reduction & buffer) {
+                        buffer.rewind();
+                        for (const_iterator it = storage.begin(); it != storage.end(); ++it) {
+                            buffer.shape();
+                            buffer.shape();
+                            it->second->pack(buffer);
+                        }
+                    }
+
+                    static void unpack_values(storage_type & storage, alps::alps_mpi::packed_reduction & buffer) {
+                        buffer.rewind();
+                        for (iterator it = storage.begin(); it != storage.end(); ++it) {
+                            buffer.shape();
+                            buffer.shape();
+                            it->second->unpack(buffer);
+                        }
+                    }
+#endif
+
                     std::map<std::string, boost::shared_ptr<T> > m_storage;
+                    /// Count and modification stamp of the accumulators at the last save, to `m_saved_location`
+                    typedef std::pair<boost::uint64_t, boost::uint64_t> saved_state;
+                    typedef std::map<std::string, saved_state> saved_type;
+                    mutable saved_type m_saved;
+                    mutable std::string m_saved_location;
                     static std::vector<boost::shared_ptr<detail::serializable_type<T> > > m_types;
                     static std::mutex m_types_mutex;
             };
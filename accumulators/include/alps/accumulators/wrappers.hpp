@@ -15,6 +15,7 @@
 // #include <alps/accumulators/feature/weight.hpp>
 #include <alps/accumulators/feature/max_num_binning.hpp>
 #include <alps/accumulators/feature/binning_analysis.hpp>
+#include <alps/accumulators/computed.hpp>
 
 #include <alps/hdf5/archive.hpp>
 
@@ -23,6 +24,7 @@
 #include <boost/variant/apply_visitor.hpp>
 
 #include <boost/mpl/if.hpp>
+#include <boost/utility/enable_if.hpp>
 
 #include <typeinfo>
 #include <stdexcept>
@@ -41,6 +43,22 @@ namespace alps {
             //     boost::mpl::vector<ALPS_ACCUMULATOR_VALUE_TYPES>
             // >::type weight_variant_type;
 
+            /// Add the computed sample `src` to `acc`, which has no error: directly to its sum
+            template<typename A> typename boost::disable_if<typename has_feature<A, error_tag>::type>::type
+            add_computed(A & acc, computed<typename computed_element<typename value_type<A>::type>::type> const & src) {
+                acc.add_computed(src);
+            }
+
+            /// Add the computed sample `src` to `acc`, which needs the sample itself: it is evaluated into a buffer
+            /** The buffer is kept per thread (and per value type), so that adding a sample does
+                not allocate once the buffer has reached the size of the samples. */
+            template<typename A> typename boost::enable_if<typename has_feature<A, error_tag>::type>::type
+            add_computed(A & acc, computed<typename computed_element<typename value_type<A>::type>::type> const & src) {
+                static thread_local typename value_type<A>::type buffer;
+                evaluate_computed(buffer, src);
+                acc(buffer);
+            }
+
         }
 
         template<typename T> class base_wrapper : public 
@@ -60,6 +78,8 @@ namespace alps {
                 virtual ~base_wrapper() {}
 
                 virtual void operator()(value_type const & value) = 0;
+                virtual void add_range(value_type const * first, value_type const * last) = 0;
+                virtual void add_computed(computed<typename detail::computed_element<value_type>::type> const & src) = 0;
                 // virtual void operator()(value_type const & value, detail::weight_variant_type const & weight) = 0;
 
                 virtual void save(hdf5::archive & ar) const = 0;
@@ -72,6 +92,12 @@ namespace alps {
                 virtual void merge(const base_wrapper<T>&) = 0;
 #ifdef ALPS_HAVE_MPI
                 virtual void collective_merge(alps::mpi::communicator const & comm, int root) = 0;
+
+                /// passes of the packed merge of many accumulators, see `alps::alps_mpi::packed_reduction`
+                virtual void pack_shape(alps::alps_mpi::packed_reduction & buffer) const = 0;
+                virtual void pack_gather(alps::alps_mpi::packed_reduction & buffer) const = 0;
+                virtual void pack(alps::alps_mpi::packed_reduction & buffer) const = 0;
+                virtual void unpack(alps::alps_mpi::packed_reduction & buffer) = 0;
 #endif
 
                 virtual base_wrapper * clone() const = 0;
@@ -198,6 +224,14 @@ namespace alps {
                     this->m_data(value);
                 }
 
+                void add_range(value_type const * first, value_type const * last) {
+                    this->m_data.add_range(first, last);
+                }
+
+                void add_computed(computed<typename detail::computed_element<value_type>::type> const & src) {
+                    detail::add_computed(this->m_data, src);
+                }
+
             public:
                 void save(hdf5::archive & ar) const { 
                     ar[""] = this->m_data; 
@@ -234,6 +268,19 @@ namespace alps {
                 ) const {
                     this->m_data.collective_merge(comm, root);
                 }
+
+                void pack_shape(alps::alps_mpi::packed_reduction & buffer) const {
+                    this->m_data.pack_shape(buffer);
+                }
+                void pack_gather(alps::alps_mpi::packed_reduction & buffer) const {
+                    this->m_data.pack_gather(buffer);
+                }
+                void pack(alps::alps_mpi::packed_reduction & buffer) const {
+                    this->m_data.pack(buffer);
+                }
+                void unpack(alps::alps_mpi::packed_reduction & buffer) {
+                    this->m_data.unpack(buffer);
+                }
 #endif
         };
 
@@ -0,0 +1,402 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+#include <alps/accumulators.hpp>
+#include <alps/accumulators/result_expression.hpp>
+#include <alps/numeric/special_functions.hpp>
+#include <alps/numeric/vector_functions.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace alps {
+    namespace accumulators {
+
+        namespace detail {
+
+            /// A node of the expression tree; the operands of a node are never modified
+            struct expression_node {
+                enum kind_type { leaf, scalar, unary, binary };
+                enum operation_type {
+                    none, add, sub, mul, div, negate, inverse,
+                    sin, cos, tan, sinh, cosh, tanh, asin, acos, atan, abs, sqrt, log, sq, cb, cbrt
+                };
+
+                kind_type kind;
+                operation_type operation;
+                long double value;
+                boost::shared_ptr<expression_node const> lhs, rhs;
+                result_wrapper const * result;
+                boost::shared_ptr<result_wrapper const> owned_result;
+            };
+
+        }
+
+        namespace {
+
+            typedef detail::expression_node node_type;
+            typedef result_expression::node_pointer node_pointer;
+
+            node_pointer make_leaf(result_wrapper const * result, boost::shared_ptr<result_wrapper const> const & owned) {
+                boost::shared_ptr<node_type> node(new node_type());
+                node->kind = node_type::leaf;
+                node->operation = node_type::none;
+                node->value = 0;
+                node->result = result;
+                node->owned_result = owned;
+                return node;
+            }
+
+            result_expression make_operation(node_type::kind_type kind, node_type::operation_type operation,
+                                             node_pointer const & lhs, node_pointer const & rhs = node_pointer(), long double value = 0) {
+                boost::shared_ptr<node_type> node(new node_type());
+                node->kind = kind;
+                node->operation = operation;
+                node->value = value;
+                node->lhs = lhs;
+                node->rhs = rhs;
+                node->result = NULL;
+                return result_expression(node_pointer(node));
+            }
+
+            result_wrapper apply_function(node_type::operation_type operation, result_wrapper const & arg) {
+                switch (operation) {
+                    case node_type::negate: return -arg;
+                    case node_type::inverse: return arg.inverse();
+                    case node_type::sin: return arg.sin();
+                    case node_type::cos: return arg.cos();
+                    case node_type::tan: return arg.tan();
+                    case node_type::sinh: return arg.sinh();
+                    case node_type::cosh: return arg.cosh();
+                    case node_type::tanh: return arg.tanh();
+                    case node_type::asin: return arg.asin();
+                    case node_type::acos: return arg.acos();
+                    case node_type::atan: return arg.atan();
+                    case node_type::abs: return arg.abs();
+                    case node_type::sqrt: return arg.sqrt();
+                    case node_type::log: return arg.log();
+                    case node_type::sq: return arg.sq();
+                    case node_type::cb: return arg.cb();
+                    case node_type::cbrt: return arg.cbrt();
+                    default: throw std::logic_error("Unknown function in result expression" + ALPS_STACKTRACE);
+                }
+            }
+
+            template<typename R> void apply_operation(node_type::operation_type operation, result_wrapper & lhs, R const & rhs) {
+                switch (operation) {
+                    case node_type::add: lhs += rhs; break;
+                    case node_type::sub: lhs -= rhs; break;
+                    case node_type::mul: lhs *= rhs; break;
+                    case node_type::div: lhs /= rhs; break;
+                    default: throw std::logic_error("Unknown operation in result expression" + ALPS_STACKTRACE);
+                }
+            }
+
+            /// Evaluates the expression operation by operation, as the operators of result_wrapper do
+            /** `leaf(result)` gives the operand used for the result `result`. */
+            template<typename L> result_wrapper evaluate_operations(node_type const & node, L const & leaf) {
+                switch (node.kind) {
+                    case node_type::leaf:
+                        return leaf(*node.result);
+                    case node_type::scalar: {
+                        result_wrapper lhs = evaluate_operations(*node.lhs, leaf);
+                        apply_operation(node.operation, lhs, node.value);
+                        return lhs;
+                    }
+                    case node_type::unary:
+                        return apply_function(node.operation, evaluate_operations(*node.lhs, leaf));
+                    case node_type::binary: {
+                        result_wrapper lhs = evaluate_operations(*node.lhs, leaf);
+                        if (node.rhs->kind == node_type::leaf)
+                            apply_operation(node.operation, lhs, leaf.reference(*node.rhs->result));
+                        else
+                            apply_operation(node.operation, lhs, evaluate_operations(*node.rhs, leaf));
+                        return lhs;
+                    }
+                }
+                throw std::logic_error("Invalid result expression" + ALPS_STACKTRACE);
+            }
+
+            /// Operands of the operation-by-operation evaluation: the results themselves
+            struct result_leaf {
+                result_wrapper operator()(result_wrapper const & result) const { return result; }
+                result_wrapper const & reference(result_wrapper const & result) const { return result; }
+            };
+
+            /// Operands of the evaluation of the binning analysis: the results without their bins
+            template<typename T> struct binning_analysis_leaf {
+                typedef typename FullBinningAccumulator<T>::result_type full_type;
+                typedef typename LogBinningAccumulator<T>::result_type log_type;
+                result_wrapper operator()(result_wrapper const & result) const {
+                    return result_wrapper(static_cast<log_type const &>(result.extract<full_type>()));
+                }
+                result_wrapper reference(result_wrapper const & result) const { return (*this)(result); }
+            };
+
+            /// The expression in postfix order, evaluated for every bin
+            template<typename T> class bin_program {
+                public:
+                    typedef typename FullBinningAccumulator<T>::result_type full_type;
+                    typedef std::vector<typename mean_type<full_type>::type> bins_type;
+
+                    /// Compiles the expression; false if an operand is not a full binning result of scalar type `T`
+                    bool compile(node_type const & node) {
+                        switch (node.kind) {
+                            case node_type::leaf: {
+                                full_type const * result = extract_full(*node.result);
+                                if (result == NULL)
+                                    return false;
+                                m_operands.push_back(result);
+                                break;
+                            }
+                            case node_type::scalar:
+                            case node_type::unary:
+                                if (!compile(*node.lhs))
+                                    return false;
+                                break;
+                            case node_type::binary:
+                                if (!compile(*node.lhs) || !compile(*node.rhs))
+                                    return false;
+                                break;
+                        }
+                        m_program.push_back(&node);
+                        return true;
+                    }
+
+                    /// The leftmost operand, whose bin size the result of the expression has
+                    full_type const & first_operand() const { return *m_operands.front(); }
+
+                    /// Evaluates the expression for all bins (`jackknife == false`) or jackknife bins
+                    /** Every operation is applied to all bins at once; the intermediate values
+                        are kept in a stack of bin vectors, reused across operations. */
+                    bins_type evaluate(bool jackknife) {
+                        std::size_t size = 0;
+                        for (std::size_t i = 0; i < m_operands.size(); ++i) {
+                            bins_type const & operand = bins(*m_operands[i], jackknife);
+                            if (i > 0 && operand.size() != size)
+                                throw std::runtime_error("Unable to transform: unequal number of bins" + ALPS_STACKTRACE);
+                            size = operand.size();
+                        }
+                        std::vector<bins_type> stack;
+                        std::size_t depth = 0, operand = 0;
+                        for (typename std::vector<node_type const *>::const_iterator it = m_program.begin(); it != m_program.end(); ++it) {
+                            node_type const & node = **it;
+                            switch (node.kind) {
+                                case node_type::leaf: {
+                                    bins_type const & values = bins(*m_operands[operand++], jackknife);
+                                    if (it + 1 != m_program.end() && (*(it + 1))->kind == node_type::binary) {
+                                        // the right operand of the next operation is used in place
+                                        ++it;
+                                        apply((*it)->operation, stack[depth - 1], values);
+                                        break;
+                                    }
+                                    if (stack.size() == depth)
+                                        stack.push_back(bins_type());
+                                    stack[depth++].assign(values.begin(), values.end());
+                                    break;
+                                }
+                                case node_type::scalar:
+                                    apply(node.operation, stack[depth - 1], static_cast<T>(node.value));
+                                    break;
+                                case node_type::unary:
+                                    apply(node.operation, stack[depth - 1]);
+                                    break;
+                                case node_type::binary:
+                                    apply(node.operation, stack[depth - 2], stack[depth - 1]);
+                                    --depth;
+                                    break;
+                            }
+                        }
+                        bins_type values;
+                        values.swap(stack.front());
+                        return values;
+                    }
+
+                private:
+                    static full_type const * extract_full(result_wrapper const & result) {
+                        try {
+                            return &result.extract<full_type>();
+                        } catch (std::bad_cast const &) {
+                            return NULL;
+                        }
+                    }
+
+                    /// The jackknife bins are generated in the operand, and kept there
+                    static bins_type const & bins(full_type const & operand, bool jackknife) {
+                        if (!jackknife)
+                            return operand.get_bins();
+                        operand.generate_jackknife();
+                        return operand.get_jackknife_bins();
+                    }
+
+                    /// The same operations as the transforms of the full binning results
+                    template<typename R> static void apply(node_type::operation_type operation, bins_type & lhs, R const & rhs) {
+                        switch (operation) {
+                            case node_type::add: for (std::size_t i = 0; i < lhs.size(); ++i) lhs[i] = lhs[i] + element(rhs, i); break;
+                            case node_type::sub: for (std::size_t i = 0; i < lhs.size(); ++i) lhs[i] = lhs[i] - element(rhs, i); break;
+                            case node_type::mul: for (std::size_t i = 0; i < lhs.size(); ++i) lhs[i] = lhs[i] * element(rhs, i); break;
+                            case node_type::div: for (std::size_t i = 0; i < lhs.size(); ++i) lhs[i] = lhs[i] / element(rhs, i); break;
+                            default: throw std::logic_error("Unknown operation in result expression" + ALPS_STACKTRACE);
+                        }
+                    }
+                    static T element(bins_type const & values, std::size_t i) { return values[i]; }
+                    static T element(T value, std::size_t) { return value; }
+
+                    static void apply(node_type::operation_type operation, bins_type & values) {
+                        using alps::numeric::sq;
+                        using alps::numeric::cb;
+                        using alps::numeric::cbrt;
+                        using std::sqrt;
+                        using std::log;
+                        using std::abs;
+                        using std::sin;
+                        using std::cos;
+                        using std::tan;
+                        using std::sinh;
+                        using std::cosh;
+                        using std::tanh;
+                        using std::asin;
+                        using std::acos;
+                        using std::atan;
+                        typedef T (*fptr_type)(T);
+                        fptr_type fptr;
+                        switch (operation) {
+                            case node_type::negate: std::transform(values.begin(), values.end(), values.begin(), alps::numeric::negate<T>()); return;
+                            case node_type::inverse: std::transform(values.begin(), values.end(), values.begin(), alps::numeric::invert<T>()); return;
+                            case node_type::sin: fptr = &sin; break;
+                            case node_type::cos: fptr = &cos; break;
+                            case node_type::tan: fptr = &tan; break;
+                            case node_type::sinh: fptr = &sinh; break;
+                            case node_type::cosh: fptr = &cosh; break;
+                            case node_type::tanh: fptr = &tanh; break;
+                            case node_type::asin: fptr = &asin; break;
+                            case node_type::acos: fptr = &acos; break;
+                            case node_type::atan: fptr = &atan; break;
+                            case node_type::abs: fptr = &abs; break;
+                            case node_type::sqrt: fptr = &sqrt; break;
+                            case node_type::log: fptr = &log; break;
+                            case node_type::sq: fptr = &sq; break;
+                            case node_type::cb: fptr = &cb; break;
+                            case node_type::cbrt: fptr = &cbrt; break;
+                            default: throw std::logic_error("Unknown function in result expression" + ALPS_STACKTRACE);
+                        }
+                        std::transform(values.begin(), values.end(), values.begin(), fptr);
+                    }
+
+                    std::vector<full_type const *> m_operands;
+                    std::vector<node_type const *> m_program;
+            };
+
+            /// Single-pass evaluation of expressions of full binning results of scalar type `T`
+            template<typename T> bool evaluate_bins(node_type const & node, result_wrapper & value) {
+                typedef typename FullBinningAccumulator<T>::result_type full_type;
+                typedef typename LogBinningAccumulator<T>::result_type log_type;
+
+                bin_program<T> program;
+                if (!program.compile(node))
+                    return false;
+                typename bin_program<T>::bins_type jackknife_bins = program.evaluate(true);
+                typename bin_program<T>::bins_type bins = program.evaluate(false);
+                result_wrapper binning_analysis = evaluate_operations(node, binning_analysis_leaf<T>());
+
+                full_type const & first = program.first_operand();
+                value = result_wrapper(full_type(binning_analysis.extract<log_type>(), std::move(bins), std::move(jackknife_bins),
+                                                 first.max_num_binning().num_elements(),
+                                                 first.max_num_binning().max_number()));
+                return true;
+            }
+        }
+
+        result_expression::result_expression(result_wrapper const & arg)
+            : m_node(make_leaf(&arg, boost::shared_ptr<result_wrapper const>()))
+        {}
+
+        result_expression::result_expression(result_wrapper && arg) {
+            boost::shared_ptr<result_wrapper const> owned(new result_wrapper(std::move(arg)));
+            m_node = make_leaf(owned.get(), owned);
+        }
+
+        result_wrapper result_expression::evaluate() const {
+            result_wrapper value;
+            if (evaluate_bins<double>(*m_node, value) || evaluate_bins<float>(*m_node, value) || evaluate_bins<long double>(*m_node, value))
+                return value;
+            return evaluate_operations(*m_node, result_leaf());
+        }
+
+        result_expression result_expression::operator-() const {
+            return make_operation(node_type::unary, node_type::negate, m_node);
+        }
+
+        result_expression result_expression::inverse() const {
+            return make_operation(node_type::unary, node_type::inverse, m_node);
+        }
+
+        #define ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(FUN)                               \
+            result_expression result_expression:: FUN () const {                       \
+                return make_operation(node_type::unary, node_type:: FUN, m_node);       \
+            }
+
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sin)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cos)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(tan)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sinh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cosh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(tanh)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(asin)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(acos)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(atan)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(abs)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sqrt)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(log)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(sq)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cb)
+            ALPS_ACCUMULATOR_EXPRESSION_FUNCTION(cbrt)
+
+        #undef ALPS_ACCUMULATOR_EXPRESSION_FUNCTION
+
+        // The operations with a scalar on the left are rewritten as the operators of result_wrapper do
+        #define ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(OPNAME, OPERATION)                                                       \
+            result_expression OPNAME (result_expression const & lhs, result_expression const & rhs) {                         \
+                return make_operation(node_type::binary, node_type:: OPERATION, lhs.node(), rhs.node());                      \
+            }                                                                                                                 \
+            result_expression OPNAME (result_expression const & lhs, result_wrapper const & rhs) {                            \
+                return OPNAME (lhs, lazy(rhs));                                                                               \
+            }                                                                                                                 \
+            result_expression OPNAME (result_expression const & lhs, result_wrapper && rhs) {                                 \
+                return OPNAME (lhs, lazy(std::move(rhs)));                                                                    \
+            }                                                                                                                 \
+            result_expression OPNAME (result_wrapper const & lhs, result_expression const & rhs) {                            \
+                return OPNAME (lazy(lhs), rhs);                                                                               \
+            }                                                                                                                 \
+            result_expression OPNAME (result_wrapper && lhs, result_expression const & rhs) {                                 \
+                return OPNAME (lazy(std::move(lhs)), rhs);                                                                    \
+            }                                                                                                                 \
+            result_expression OPNAME (result_expression const & lhs, long double rhs) {                                       \
+                return make_operation(node_type::scalar, node_type:: OPERATION, lhs.node(), node_pointer(), rhs);             \
+            }
+        ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator+, add)
+        ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator-, sub)
+        ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator*, mul)
+        ALPS_ACCUMULATOR_EXPRESSION_OPERATOR(operator/, div)
+        #undef ALPS_ACCUMULATOR_EXPRESSION_OPERATOR
+
+        result_expression operator+(long double lhs, result_expression const & rhs) {
+            return rhs + lhs;
+        }
+        result_expression operator-(long double lhs, result_expression const & rhs) {
+            return -rhs + lhs;
+        }
+        result_expression operator*(long double lhs, result_expression const & rhs) {
+            return rhs * lhs;
+        }
+        result_expression operator/(long double lhs, result_expression const & rhs) {
+            return rhs.inverse() * lhs;
+        }
+    }
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file accumulator_handle.cpp
+    Test adding values to accumulators via handles
+*/
+
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <typeinfo>
+
+namespace aa=alps::accumulators;
+
+TEST(accumulators, HandleScalar) {
+    aa::accumulator_set by_name, by_handle;
+    by_name << aa::FullBinningAccumulator<double>("data");
+    by_handle << aa::FullBinningAccumulator<double>("data");
+
+    aa::accumulator_handle< aa::FullBinningAccumulator<double> > h=by_handle.handle< aa::FullBinningAccumulator<double> >("data");
+    for (int i=0; i<1000; ++i) {
+        double v=0.5+0.25*(i%7);
+        by_name["data"] << v;
+        h << v;
+    }
+
+    EXPECT_EQ(by_name["data"].count(), by_handle["data"].count());
+    EXPECT_EQ(by_name["data"].mean<double>(), by_handle["data"].mean<double>());
+    EXPECT_EQ(by_name["data"].error<double>(), by_handle["data"].error<double>());
+}
+
+TEST(accumulators, HandleVector) {
+    typedef std::vector<double> vtype;
+    aa::accumulator_set mset;
+    mset << aa::NoBinningAccumulator<vtype>("data");
+
+    aa::accumulator_handle< aa::NoBinningAccumulator<vtype> > h=mset.handle< aa::NoBinningAccumulator<vtype> >("data");
+    h << vtype(3, 1.) << vtype(3, 3.);
+
+    EXPECT_EQ(2u, mset["data"].count());
+    vtype mean=mset["data"].mean<vtype>();
+    ASSERT_EQ(3u, mean.size());
+    EXPECT_EQ(2., mean[1]);
+
+    EXPECT_THROW(h << vtype(), std::runtime_error);
+}
+
+TEST(accumulators, HandleSharedWithSet) {
+    aa::accumulator_set mset;
+    mset << aa::MeanAccumulator<double>("data");
+    aa::accumulator_handle< aa::MeanAccumulator<double> > h=mset.handle< aa::MeanAccumulator<double> >("data");
+    aa::accumulator_handle< aa::MeanAccumulator<double> > hcopy=h;
+
+    h << 1.;
+    hcopy << 3.;
+    mset["data"] << 5.;
+    EXPECT_EQ(3u, mset["data"].count());
+    EXPECT_EQ(3u, h.extract().count());
+
+    mset.reset();
+    EXPECT_EQ(0u, h.extract().count());
+    h << 2.;
+    EXPECT_EQ(2., mset["data"].mean<double>());
+}
+
+TEST(accumulators, HandleErrors) {
+    aa::accumulator_set mset;
+    mset << aa::MeanAccumulator<double>("data");
+    EXPECT_THROW(mset.handle< aa::MeanAccumulator<double> >("nosuchname"), std::out_of_range);
+    EXPECT_THROW(mset.handle< aa::FullBinningAccumulator<double> >("data"), std::bad_cast);
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file add_range.cpp
+    Test that adding ranges of samples gives the same state as adding samples one by one
+*/
+
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    double gen_scalar(int i) { return std::sin(0.37*i)+0.01*(i%13); }
+
+    void gen(double& v, int i) { v=gen_scalar(i); }
+
+    void gen(std::vector<double>& v, int i) {
+        v.resize(4);
+        for (std::size_t j=0; j<v.size(); ++j) v[j]=gen_scalar(i)*(j+1)+0.5*j;
+    }
+
+    // Block sizes used to chop the sample sequence, crossing the binning level boundaries
+    const std::size_t block_sizes[]={ 1, 3, 7, 64, 2, 513, 1, 900, 31 };
+    const std::size_t nblocks=sizeof(block_sizes)/sizeof(*block_sizes);
+
+    template <typename T>
+    std::vector<T> gen_samples() {
+        std::size_t nsamples=0;
+        for (std::size_t b=0; b<nblocks; ++b) nsamples+=block_sizes[b];
+        std::vector<T> samples(nsamples);
+        for (std::size_t i=0; i<nsamples; ++i) gen(samples[i], i);
+        return samples;
+    }
+
+    template <typename A>
+    void fill(aa::accumulator_wrapper& one_by_one, aa::accumulator_wrapper& by_range) {
+        typedef typename aa::value_type<typename A::accumulator_type>::type value_type;
+        const std::vector<value_type> samples=gen_samples<value_type>();
+        for (std::size_t i=0; i<samples.size(); ++i) one_by_one << samples[i];
+
+        const value_type* p=&samples[0];
+        for (std::size_t b=0; b<nblocks; ++b) {
+            by_range.add_range(p, p+block_sizes[b]);
+            p+=block_sizes[b];
+        }
+        by_range.add_range(p, p); // empty range
+    }
+}
+
+template <typename A>
+class AccumulatorAddRangeTest : public ::testing::Test {
+  public:
+    typedef typename aa::value_type<typename A::accumulator_type>::type value_type;
+    aa::accumulator_set mset;
+
+    AccumulatorAddRangeTest() {
+        mset << A("one_by_one") << A("by_range");
+        fill<A>(mset["one_by_one"], mset["by_range"]);
+    }
+};
+
+typedef ::testing::Types<
+    aa::MeanAccumulator<double>,
+    aa::NoBinningAccumulator<double>,
+    aa::LogBinningAccumulator<double>,
+    aa::FullBinningAccumulator<double>,
+    aa::LogBinningAccumulator< std::vector<double> >,
+    aa::FullBinningAccumulator< std::vector<double> >
+    > test_types;
+
+TYPED_TEST_CASE(AccumulatorAddRangeTest, test_types);
+
+TYPED_TEST(AccumulatorAddRangeTest, SameAsOneByOne) {
+    typedef typename TestFixture::value_type value_type;
+    aa::accumulator_wrapper& a=this->mset["one_by_one"];
+    aa::accumulator_wrapper& b=this->mset["by_range"];
+
+    EXPECT_EQ(a.count(), b.count());
+    EXPECT_EQ(a.mean<value_type>(), b.mean<value_type>());
+
+    aa::result_set results(this->mset);
+    EXPECT_EQ(results["one_by_one"].mean<value_type>(), results["by_range"].mean<value_type>());
+    typedef typename TypeParam::accumulator_type acc_type;
+    if (aa::has_feature<acc_type, aa::error_tag>::type::value) {
+        EXPECT_EQ(results["one_by_one"].error<value_type>(), results["by_range"].error<value_type>());
+    }
+    if (aa::has_feature<acc_type, aa::binning_analysis_tag>::type::value) {
+        EXPECT_EQ(results["one_by_one"].autocorrelation<value_type>(), results["by_range"].autocorrelation<value_type>());
+    }
+}
+
+TEST(AccumulatorAddRange, FullBinningBins) {
+    typedef aa::FullBinningAccumulator<double> named_type;
+    typedef named_type::accumulator_type acc_type;
+    const std::vector<double> samples=gen_samples<double>();
+
+    acc_type one_by_one, by_range;
+    for (std::size_t i=0; i<samples.size(); ++i) one_by_one(samples[i]);
+    by_range.add_range(&samples[0], &samples[0]+samples.size());
+
+    EXPECT_EQ(one_by_one.count(), by_range.count());
+    EXPECT_EQ(one_by_one.max_num_binning().bins(), by_range.max_num_binning().bins());
+    EXPECT_EQ(one_by_one.error(), by_range.error());
+    EXPECT_EQ(one_by_one.autocorrelation(), by_range.autocorrelation());
+}
+
+TEST(AccumulatorAddRange, ThroughHandle) {
+    typedef aa::LogBinningAccumulator<double> named_type;
+    const std::vector<double> samples=gen_samples<double>();
+    aa::accumulator_set mset;
+    mset << named_type("one_by_one") << named_type("by_range");
+    for (std::size_t i=0; i<samples.size(); ++i) mset["one_by_one"] << samples[i];
+    aa::accumulator_handle<named_type> h=mset.handle<named_type>("by_range");
+    h.add_range(&samples[0], &samples[0]+samples.size());
+
+    EXPECT_EQ(mset["one_by_one"].count(), mset["by_range"].count());
+    EXPECT_EQ(mset["one_by_one"].error<double>(), mset["by_range"].error<double>());
+}
+
+TEST(AccumulatorAddRange, Errors) {
+    aa::accumulator_set mset;
+    mset << aa::MeanAccumulator<double>("scalar") << aa::MeanAccumulator< std::vector<double> >("vector");
+
+    const float fsamples[]={ 1., 2. };
+    EXPECT_THROW(mset["scalar"].add_range(fsamples, fsamples+2), std::logic_error);
+
+    std::vector< std::vector<double> > vsamples(2);
+    vsamples[0].resize(3);
+    EXPECT_THROW(mset["vector"].add_range(&vsamples[0], &vsamples[0]+2), std::runtime_error);
+    EXPECT_EQ(0u, mset["vector"].count());
+
+    const double dsamples[]={ 1., 2. };
+    aa::accumulator_set scalar_set;
+    scalar_set << aa::MeanAccumulator<double>("scalar");
+    scalar_set["scalar"].add_range(dsamples, dsamples+2);
+    aa::result_set results(scalar_set);
+    EXPECT_THROW(results["scalar"].extract< aa::MeanAccumulator<double>::result_type >().add_range(dsamples, dsamples+2), std::runtime_error);
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file bin_slab.cpp
+    Test the contiguous bin storage of vector-valued full binning accumulators
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const std::size_t nelem=3;
+
+    double gen(int i, std::size_t k) { return std::sin(0.37*i+k)+0.5*k; }
+}
+
+/// The bins of a vector accumulator are, element by element, the bins of scalar accumulators
+class BinSlabTest : public ::testing::TestWithParam<std::size_t> {
+  public:
+    aa::accumulator_set measurements;
+
+    BinSlabTest() {
+        measurements << aa::FullBinningAccumulator< std::vector<double> >("vector", aa::max_bin_number=GetParam());
+        for (std::size_t k=0; k<nelem; ++k)
+            measurements << aa::FullBinningAccumulator<double>(name(k), aa::max_bin_number=GetParam());
+    }
+
+    static std::string name(std::size_t k) { return "scalar"+std::to_string(k); }
+
+    void add(int first, int last, bool query) {
+        std::vector<double> v(nelem);
+        for (int i=first; i<last; ++i) {
+            for (std::size_t k=0; k<nelem; ++k) {
+                v[k]=gen(i, k);
+                measurements[name(k)] << v[k];
+            }
+            measurements["vector"] << v;
+            if (query && i%7==0)
+                bins(measurements["vector"]);
+        }
+    }
+
+    template <typename A>
+    static std::vector<typename aa::value_type<A>::type> bins_of(aa::accumulator_wrapper& acc) {
+        return acc.extract<A>().max_num_binning().bins();
+    }
+
+    static std::vector< std::vector<double> > bins(aa::accumulator_wrapper& acc) {
+        return bins_of<aa::FullBinningAccumulator< std::vector<double> >::accumulator_type>(acc);
+    }
+
+    void expect_same_bins() {
+        const std::vector< std::vector<double> > vbins=bins(measurements["vector"]);
+        for (std::size_t k=0; k<nelem; ++k) {
+            const std::vector<double> sbins=bins_of<aa::FullBinningAccumulator<double>::accumulator_type>(measurements[name(k)]);
+            ASSERT_EQ(sbins.size(), vbins.size());
+            for (std::size_t i=0; i<sbins.size(); ++i)
+                EXPECT_EQ(sbins[i], vbins[i][k]) << "bin " << i << " element " << k;
+        }
+    }
+};
+
+TEST_P(BinSlabTest, SameAsScalars) {
+    add(0, 1000, false);
+    expect_same_bins();
+    add(1000, 3333, false);
+    expect_same_bins();
+}
+
+TEST_P(BinSlabTest, QueriesDoNotChangeBins) {
+    add(0, 3333, true);
+    expect_same_bins();
+}
+
+TEST_P(BinSlabTest, MergeAndSave) {
+    add(0, 1000, false);
+    aa::accumulator_set other;
+    other << aa::FullBinningAccumulator< std::vector<double> >("vector", aa::max_bin_number=GetParam());
+    for (std::size_t k=0; k<nelem; ++k)
+        other << aa::FullBinningAccumulator<double>(name(k), aa::max_bin_number=GetParam());
+    std::vector<double> v(nelem);
+    for (int i=0; i<500; ++i) {
+        for (std::size_t k=0; k<nelem; ++k) {
+            v[k]=gen(-i, k);
+            other[name(k)] << v[k];
+        }
+        other["vector"] << v;
+    }
+    measurements.merge(other);
+    expect_same_bins();
+    // the merged bins go back into the slab with the next samples
+    add(1000, 1500, false);
+    expect_same_bins();
+
+    alps::testing::unique_file ufile("bin_slab.h5.", alps::testing::unique_file::REMOVE_AFTER);
+    {
+        alps::hdf5::archive ar(ufile.name(), "w");
+        ar["measurements"] << measurements;
+    }
+    aa::accumulator_set loaded;
+    {
+        alps::hdf5::archive ar(ufile.name(), "r");
+        ar["measurements"] >> loaded;
+    }
+    EXPECT_EQ(bins(measurements["vector"]), bins(loaded["vector"]));
+}
+
+INSTANTIATE_TEST_CASE_P(MaxBinNumber, BinSlabTest, ::testing::Values(128, 16, 15));
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file computed_samples.cpp
+    Test that computed samples add the same as the samples they compute
+*/
+
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const std::size_t nelements=50;
+
+    /// A histogram entry: the sample is 1 in bin `i` and 0 elsewhere
+    struct histogram_entry : public aa::computed<double> {
+        histogram_entry(std::size_t i) : index(i) {}
+        std::size_t size() const { return nelements; }
+        void add_to(double * out) const { out[index] += 1; }
+        std::size_t index;
+    };
+
+    std::size_t gen(int i) { return (i*i+7*i)%nelements; }
+
+    std::vector<double> gen_vector(int i) {
+        std::vector<double> v(nelements);
+        v[gen(i)]=1;
+        return v;
+    }
+}
+
+template <typename A>
+class ComputedSamplesTest : public ::testing::Test {
+  public:
+    aa::accumulator_set measurements;
+
+    ComputedSamplesTest() {
+        measurements << A("vector") << A("computed");
+    }
+
+    void add(int n) {
+        for (int i=0; i<n; ++i) {
+            measurements["vector"] << gen_vector(i);
+            measurements["computed"] << histogram_entry(gen(i));
+        }
+    }
+};
+
+typedef ::testing::Types<
+    aa::MeanAccumulator< std::vector<double> >,
+    aa::NoBinningAccumulator< std::vector<double> >,
+    aa::LogBinningAccumulator< std::vector<double> >,
+    aa::FullBinningAccumulator< std::vector<double> >
+    > test_types;
+
+TYPED_TEST_CASE(ComputedSamplesTest, test_types);
+
+TYPED_TEST(ComputedSamplesTest, SameAsVector) {
+    this->add(1000);
+    aa::result_set results(this->measurements);
+    EXPECT_EQ(results["vector"].count(), results["computed"].count());
+    EXPECT_EQ(results["vector"].template mean< std::vector<double> >(), results["computed"].template mean< std::vector<double> >());
+    if (aa::has_feature<typename TypeParam::accumulator_type, aa::error_tag>::type::value)
+        EXPECT_EQ(results["vector"].template error< std::vector<double> >(), results["computed"].template error< std::vector<double> >());
+}
+
+TYPED_TEST(ComputedSamplesTest, Handle) {
+    aa::accumulator_handle<TypeParam> handle=this->measurements.template handle<TypeParam>("computed");
+    for (int i=0; i<100; ++i) {
+        this->measurements["vector"] << gen_vector(i);
+        handle << histogram_entry(gen(i));
+    }
+    EXPECT_EQ(this->measurements["vector"].count(), this->measurements["computed"].count());
+    EXPECT_EQ(this->measurements["vector"].template mean< std::vector<double> >(),
+              this->measurements["computed"].template mean< std::vector<double> >());
+}
+
+TEST(ComputedSamples, WrongType) {
+    aa::accumulator_set measurements;
+    measurements << aa::MeanAccumulator< std::vector<float> >("float")
+                 << aa::MeanAccumulator<double>("scalar");
+    EXPECT_THROW(measurements["float"] << histogram_entry(0), std::logic_error);
+    // a scalar accumulator takes computed samples of size 1 only
+    EXPECT_THROW(measurements["scalar"] << histogram_entry(0), std::runtime_error);
+}
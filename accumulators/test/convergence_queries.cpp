@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file convergence_queries.cpp
+    Test the cached error and convergence queries of the binning accumulators
+*/
+
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    template <typename T> struct sample_maker {
+        static T make(double x) { return x; }
+    };
+
+    template <typename T> struct sample_maker< std::vector<T> > {
+        static std::vector<T> make(double x) {
+            std::vector<T> v(3);
+            v[0]=x; v[1]=2*x; v[2]=x+1;
+            return v;
+        }
+    };
+
+    template <typename T> std::vector<double> as_vector(T const & x) { return std::vector<double>(1, x); }
+    template <typename T> std::vector<double> as_vector(std::vector<T> const & x) { return std::vector<double>(x.begin(), x.end()); }
+}
+
+template <typename A>
+class ConvergenceQueriesTest : public ::testing::Test {
+  public:
+    typedef typename A::accumulator_type acc_type;
+    typedef typename aa::value_type<acc_type>::type value_type;
+
+    aa::accumulator_set mset;
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> noise;
+
+    ConvergenceQueriesTest() : rng(1234), noise(-0.5, 0.5) {
+        mset << A("x");
+    }
+
+    acc_type const & acc() { return mset["x"].extract<acc_type>(); }
+
+    void add(std::size_t n) {
+        for (std::size_t i=0; i<n; ++i)
+            mset["x"] << sample_maker<value_type>::make(1.+noise(rng));
+    }
+};
+
+typedef ::testing::Types<
+    aa::LogBinningAccumulator<double>,
+    aa::FullBinningAccumulator<double>,
+    aa::LogBinningAccumulator< std::vector<double> >,
+    aa::FullBinningAccumulator< std::vector<double> >
+> binning_types;
+TYPED_TEST_CASE(ConvergenceQueriesTest, binning_types);
+
+TYPED_TEST(ConvergenceQueriesTest, CachedSameAsComputed) {
+    for (int k=0; k<60; ++k) {
+        this->add(97);
+        EXPECT_EQ(as_vector(this->acc().error()), as_vector(this->acc().cached_error()));
+        EXPECT_EQ(as_vector(this->acc().converged_errors()), as_vector(this->acc().cached_converged_errors()));
+    }
+    // right after a bin closes at every level, all cached values are current
+    this->add((1<<13)-this->acc().count());
+    EXPECT_EQ(as_vector(this->acc().autocorrelation()), as_vector(this->acc().cached_autocorrelation()));
+}
+
+TYPED_TEST(ConvergenceQueriesTest, ReachedPrecision) {
+    this->add(1000);
+    EXPECT_FALSE(this->acc().reached_precision(1.)) << "Convergence needs at least 1024 samples";
+    EXPECT_FALSE(this->mset["x"].reached_precision(1.));
+
+    while (this->acc().count()<(1<<20) && !this->mset["x"].reached_precision(0.01))
+        this->add(100);
+    ASSERT_TRUE(this->acc().reached_precision(0.01));
+    EXPECT_FALSE(this->acc().reached_precision(1E-6));
+
+    const std::vector<double> err=as_vector(this->acc().error()), mean=as_vector(this->acc().mean());
+    const std::vector<double> conv=as_vector(this->acc().converged_errors());
+    for (std::size_t i=0; i<err.size(); ++i) {
+        EXPECT_LE(err[i], 0.0101*std::fabs(mean[i]));
+        EXPECT_EQ(double(alps::CONVERGED), conv[i]);
+    }
+}
+
+TYPED_TEST(ConvergenceQueriesTest, ResetAndMerge) {
+    this->add(1<<12);
+    this->acc().cached_error();
+    this->mset["x"].reset();
+    this->add(1);
+    EXPECT_TRUE(std::isinf(as_vector(this->acc().cached_error())[0]));
+    EXPECT_FALSE(this->acc().reached_precision(1.));
+
+    this->add(1<<12);
+    this->acc().cached_error();
+    aa::accumulator_set other;
+    other << TypeParam("x");
+    for (int i=0; i<5000; ++i)
+        other["x"] << sample_maker<typename TestFixture::value_type>::make(1.+0.1*std::sin(i));
+    this->mset.merge(other);
+    EXPECT_EQ(as_vector(this->acc().error()), as_vector(this->acc().cached_error()));
+}
+
+TEST(ConvergenceQueries, NoBinningAnalysis) {
+    aa::accumulator_set mset;
+    mset << aa::MeanAccumulator<double>("mean") << aa::NoBinningAccumulator<double>("nobin");
+    mset["mean"] << 1.;
+    mset["nobin"] << 1.;
+    EXPECT_THROW(mset["mean"].reached_precision(1.), std::runtime_error);
+    EXPECT_THROW(mset["nobin"].reached_precision(1.), std::runtime_error);
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file eigen_samples.cpp
+    Test that Eigen vectors and arrays can be added to accumulators of std::vector
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const int nsamples=5000;
+    const int nelements=6;
+
+    double gen(int i, int j) { return std::sin(0.37*i+j)+0.01*(i%13)*j; }
+
+    Eigen::VectorXd gen_eigen(int i) {
+        Eigen::VectorXd v(nelements);
+        for (int j=0; j<nelements; ++j) v(j)=gen(i, j);
+        return v;
+    }
+
+    std::vector<double> gen_vector(int i) {
+        std::vector<double> v(nelements);
+        for (int j=0; j<nelements; ++j) v[j]=gen(i, j);
+        return v;
+    }
+
+    typedef aa::FullBinningAccumulator< std::vector<double> > full_type;
+
+    void expect_same(aa::accumulator_wrapper& expected, aa::accumulator_wrapper& value) {
+        EXPECT_EQ(expected.count(), value.count());
+        EXPECT_EQ(expected.mean< std::vector<double> >(), value.mean< std::vector<double> >());
+        EXPECT_EQ(expected.error< std::vector<double> >(), value.error< std::vector<double> >());
+        EXPECT_EQ(expected.extract<full_type::accumulator_type>().max_num_binning().bins(),
+                  value.extract<full_type::accumulator_type>().max_num_binning().bins());
+    }
+}
+
+class EigenSamplesTest : public ::testing::Test {
+  public:
+    aa::accumulator_set measurements;
+
+    EigenSamplesTest() {
+        measurements << full_type("vector")
+                     << full_type("eigen")
+                     << full_type("array", aa::max_bin_number=32);
+    }
+};
+
+TEST_F(EigenSamplesTest, SameAsVector) {
+    for (int i=0; i<nsamples; ++i) {
+        measurements["vector"] << gen_vector(i);
+        measurements["eigen"] << gen_eigen(i);
+    }
+    expect_same(measurements["vector"], measurements["eigen"]);
+}
+
+TEST_F(EigenSamplesTest, ExpressionsAndArrays) {
+    aa::accumulator_handle<full_type> handle(measurements["eigen"]);
+    for (int i=0; i<nsamples; ++i) {
+        const Eigen::VectorXd v=gen_eigen(i);
+        std::vector<double> twice=gen_vector(i);
+        for (std::size_t j=0; j<twice.size(); ++j) twice[j]*=2;
+        measurements["vector"] << twice;
+        handle << 2*v;
+
+        // column-major flattening of a 2x3 array
+        Eigen::ArrayXXd a(2, 3);
+        for (int j=0; j<nelements; ++j) a(j%2, j/2)=gen(i, j);
+        measurements["array"] << a;
+    }
+    expect_same(measurements["vector"], measurements["eigen"]);
+
+    const std::vector<double> mean=measurements["array"].mean< std::vector<double> >();
+    ASSERT_EQ(std::size_t(nelements), mean.size());
+    double sum=0;
+    for (int i=0; i<nsamples; ++i) sum+=gen(i, 3);
+    EXPECT_NEAR(sum/nsamples, mean[3], 1E-12);
+}
+
+TEST_F(EigenSamplesTest, WrongScalarType) {
+    EXPECT_THROW(measurements["eigen"] << Eigen::VectorXf::Ones(nelements), std::logic_error);
+    EXPECT_THROW(measurements["eigen"] << Eigen::VectorXd(), std::runtime_error);
+    EXPECT_EQ(0u, measurements["eigen"].count());
+}
+
+// Eigen samples end up in a std::vector accumulator, which is saved and loaded as usual
+TEST_F(EigenSamplesTest, SaveLoad) {
+    for (int i=0; i<nsamples; ++i) {
+        measurements["vector"] << gen_vector(i);
+        measurements["eigen"] << gen_eigen(i);
+    }
+    const std::string h5name=alps::testing::temporary_filename("eigen_samples.h5.");
+    {
+        alps::hdf5::archive ar(h5name, "w");
+        ar["acc"] << measurements["eigen"];
+    }
+    aa::accumulator_set loaded;
+    loaded << full_type("eigen");
+    {
+        alps::hdf5::archive ar(h5name, "r");
+        ar["acc"] >> loaded["eigen"];
+    }
+    expect_same(measurements["vector"], loaded["eigen"]);
+    loaded["eigen"] << gen_eigen(0);
+    EXPECT_EQ(nsamples+1, loaded["eigen"].count());
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file incremental_save.cpp
+    Test saving an accumulator set repeatedly to the same file
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    double gen(int i) { return std::sin(0.37*i)+0.5; }
+
+    typedef aa::FullBinningAccumulator<double> scalar_type;
+    typedef aa::FullBinningAccumulator< std::vector<double> > vector_type;
+
+    void fill(aa::accumulator_set& m) {
+        m << aa::MeanAccumulator<double>("mean")
+          << scalar_type("full")
+          << vector_type("vector");
+    }
+
+    void add(aa::accumulator_set& m, int first, int last) {
+        std::vector<double> v(4);
+        for (int i=first; i<last; ++i) {
+            m["mean"] << gen(i);
+            m["full"] << gen(i);
+            v.assign(v.size(), gen(i));
+            m["vector"] << v;
+        }
+    }
+}
+
+class IncrementalSaveTest : public ::testing::Test {
+  public:
+    alps::testing::unique_file ufile;
+    aa::accumulator_set measurements;
+
+    IncrementalSaveTest() : ufile("incremental_save.h5.", alps::testing::unique_file::REMOVE_AFTER) {
+        fill(measurements);
+    }
+
+    void save(aa::accumulator_set const& m) {
+        alps::hdf5::archive ar(ufile.name(), "a");
+        ar["measurements"] << m;
+    }
+
+    void expect_loaded_equal(aa::accumulator_set& expected) {
+        aa::accumulator_set loaded;
+        {
+            alps::hdf5::archive ar(ufile.name(), "r");
+            ar["measurements"] >> loaded;
+        }
+        aa::result_set rexpected(expected), rloaded(loaded);
+        const char* names[]={ "mean", "full" };
+        for (int n=0; n<2; ++n) {
+            EXPECT_EQ(rexpected[names[n]].count(), rloaded[names[n]].count()) << names[n];
+            EXPECT_NEAR(rexpected[names[n]].mean<double>(), rloaded[names[n]].mean<double>(), 1E-12) << names[n];
+        }
+        EXPECT_NEAR(rexpected["full"].error<double>(), rloaded["full"].error<double>(), 1E-12);
+        EXPECT_EQ(expected["full"].extract<scalar_type::accumulator_type>().max_num_binning().bins(),
+                  loaded["full"].extract<scalar_type::accumulator_type>().max_num_binning().bins());
+        EXPECT_EQ(expected["vector"].extract<vector_type::accumulator_type>().max_num_binning().bins(),
+                  loaded["vector"].extract<vector_type::accumulator_type>().max_num_binning().bins());
+    }
+};
+
+TEST_F(IncrementalSaveTest, UnchangedNotWritten) {
+    add(measurements, 0, 1000);
+    save(measurements);
+    {
+        // mark the saved mean, to see whether it is written again
+        alps::hdf5::archive ar(ufile.name(), "a");
+        ar["measurements/mean/mean/value"] = 42.;
+    }
+    for (int i=0; i<10; ++i) measurements["full"] << gen(i);
+    save(measurements);
+
+    alps::hdf5::archive ar(ufile.name(), "r");
+    double mean;
+    ar["measurements/mean/mean/value"] >> mean;
+    EXPECT_EQ(42., mean);
+    std::size_t count;
+    ar["measurements/full/count"] >> count;
+    EXPECT_EQ(1010u, count);
+}
+
+TEST_F(IncrementalSaveTest, NewBinsAppended) {
+    add(measurements, 0, 1000);
+    save(measurements);
+    const std::vector<double> bins=measurements["full"].extract<scalar_type::accumulator_type>().max_num_binning().bins();
+    {
+        // mark the first saved bin, to see whether it is written again
+        alps::hdf5::archive ar(ufile.name(), "a");
+        std::vector<double> saved;
+        ar["measurements/full/timeseries/data"] >> saved;
+        ASSERT_EQ(bins, saved);
+        saved[0]=42.;
+        ar.write("measurements/full/timeseries/data", &saved[0], std::vector<std::size_t>(1, saved.size()));
+    }
+    // 125 bins of 8 samples: three more bins fit without rebinning
+    add(measurements, 1000, 1024);
+    ASSERT_EQ(bins.size()+3, measurements["full"].extract<scalar_type::accumulator_type>().max_num_binning().bins().size());
+    save(measurements);
+
+    // the unmarked file holds the same as a file written at once
+    {
+        alps::hdf5::archive ar(ufile.name(), "a");
+        std::vector<double> saved;
+        ar["measurements/full/timeseries/data"] >> saved;
+        EXPECT_EQ(42., saved[0]);
+        saved[0]=bins[0];
+        ar.write("measurements/full/timeseries/data", &saved[0], std::vector<std::size_t>(1, saved.size()));
+    }
+    expect_loaded_equal(measurements);
+}
+
+TEST_F(IncrementalSaveTest, RebinnedAndReset) {
+    add(measurements, 0, 1000);
+    save(measurements);
+    // the bins are averaged in pairs
+    add(measurements, 1000, 5000);
+    save(measurements);
+    expect_loaded_equal(measurements);
+
+    // the same number of samples, but other ones
+    measurements.reset();
+    add(measurements, 10000, 15000);
+    save(measurements);
+    expect_loaded_equal(measurements);
+
+    // accumulators without samples are not saved
+    measurements.reset();
+    measurements["mean"] << 1.;
+    save(measurements);
+    alps::hdf5::archive ar(ufile.name(), "r");
+    EXPECT_TRUE(ar.is_group("measurements/mean"));
+    EXPECT_FALSE(ar.is_group("measurements/full"));
+}
+
+TEST_F(IncrementalSaveTest, PartialCheckpointDetected) {
+    add(measurements, 0, 100);
+    save(measurements);
+    expect_loaded_equal(measurements);
+    {
+        // as if the program was stopped while saving
+        alps::hdf5::archive ar(ufile.name(), "a");
+        ar["measurements/@complete"] = false;
+    }
+    aa::accumulator_set loaded;
+    alps::hdf5::archive ar(ufile.name(), "r");
+    EXPECT_THROW(ar["measurements"] >> loaded, std::runtime_error);
+}
@@ -6,6 +6,7 @@
 
 #include <alps/config.hpp>
 #include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
 #include "gtest/gtest.h"
 
 #include "accumulator_generator.hpp"
@@ -86,21 +87,21 @@ REGISTER_TYPED_TEST_CASE_P(AccumulatorMergeTest,
                            Count, Mean, ErrorBar);
 
 typedef ::testing::Types<
-    // generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 1000, 1000>,
-    // generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 1000, 2000>,
-    // generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 2000, 1000>,
+    generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 1000, 1000>,
+    generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 1000, 2000>,
+    generator<aa::FullBinningAccumulator<double>, aat::ConstantData, 2000, 1000>,
 
-    // generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 1000, 1000>,
-    // generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 2000, 1000>,
-    // generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 1000, 2000>,
+    generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 1000, 1000>,
+    generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 2000, 1000>,
+    generator<aa::FullBinningAccumulator<double>, aat::AlternatingData, 1000, 2000>,
 
-    // generator<aa::FullBinningAccumulator<double>, aat::RandomData, 1000, 1000, 4>,
-    // generator<aa::FullBinningAccumulator<double>, aat::RandomData, 1000, 3000, 4>,
-    // generator<aa::FullBinningAccumulator<double>, aat::RandomData, 3000, 1000, 4>,
+    generator<aa::FullBinningAccumulator<double>, aat::RandomData, 1000, 1000, 4>,
+    generator<aa::FullBinningAccumulator<double>, aat::RandomData, 1000, 3000, 4>,
+    generator<aa::FullBinningAccumulator<double>, aat::RandomData, 3000, 1000, 4>,
     
-    // generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 1000, 1000, 3>,
-    // generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 2000, 1000, 3>,
-    // generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 1000, 2000, 3>,
+    generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 1000, 1000, 3>,
+    generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 2000, 1000, 3>,
+    generator<aa::FullBinningAccumulator<double>, aat::CorrelatedData<5>, 1000, 2000, 3>,
 
     generator<aa::LogBinningAccumulator<double>, aat::ConstantData, 1000, 1000>,
     generator<aa::LogBinningAccumulator<double>, aat::ConstantData, 1000, 2000>,
@@ -131,3 +132,89 @@ typedef ::testing::Types<
     > MyTypes;
 
 INSTANTIATE_TYPED_TEST_CASE_P(test1, AccumulatorMergeTest, MyTypes);
+
+namespace {
+    /// The number of samples in the partial bin of a full binning accumulator and their sum, as saved
+    std::pair<std::size_t, double> saved_partial_bin(const aa::accumulator_wrapper& acc) {
+        alps::testing::unique_file ufile("merge_partial.h5.", alps::testing::unique_file::REMOVE_AFTER);
+        std::pair<std::size_t, double> partial(0, 0.);
+        alps::hdf5::archive ar(ufile.name(), "w");
+        ar["acc"] << acc;
+        if (ar.is_data("acc/timeseries/partialbin")) {
+            ar["acc/timeseries/partialbin/@count"] >> partial.first;
+            ar["acc/timeseries/partialbin"] >> partial.second;
+        }
+        return partial;
+    }
+}
+
+TEST(AccumulatorMergeFullBinning, EqualBinSizes) {
+    typedef aa::FullBinningAccumulator<double>::accumulator_type acc_type;
+    aat::RandomData gen;
+    acc_type half1, half2, full;
+    for (int i=0; i<1024; ++i) { double v=gen(); half1(v); full(v); }
+    for (int i=0; i<1024; ++i) { double v=gen(); half2(v); full(v); }
+    half1.merge(half2);
+
+    EXPECT_EQ(full.count(), half1.count());
+    aa::max_num_binning_type<acc_type>::type merged=half1.max_num_binning(), expected=full.max_num_binning();
+    EXPECT_EQ(expected.num_elements(), merged.num_elements());
+    ASSERT_EQ(expected.bins().size(), merged.bins().size());
+    for (std::size_t i=0; i<expected.bins().size(); ++i) {
+        EXPECT_NEAR(expected.bins()[i], merged.bins()[i], 1E-12) << "bin #" << i;
+    }
+}
+
+TEST(AccumulatorMergeFullBinning, DifferentBinSizes) {
+    typedef aa::FullBinningAccumulator<double> named_type;
+    aat::RandomData gen;
+    aa::accumulator_set ms1, ms2;
+    ms1 << named_type("data", aa::max_bin_number=64);
+    ms2 << named_type("data", aa::max_bin_number=64);
+    double total=0;
+    for (int i=0; i<1001; ++i) { double v=gen(); ms1["data"] << v; total+=v; }
+    for (int i=0; i<3003; ++i) { double v=gen(); ms2["data"] << v; total+=v; }
+    ms1.merge(ms2);
+
+    const named_type::accumulator_type& merged=ms1["data"].extract<named_type::accumulator_type>();
+    aa::max_num_binning_type<named_type::accumulator_type>::type mnb=merged.max_num_binning();
+    EXPECT_EQ(4004u, merged.count());
+    EXPECT_LE(mnb.bins().size(), 64u);
+    EXPECT_EQ(64u, mnb.num_elements());
+
+    // No sample is lost: the samples not in the bins are in the partial bin
+    const std::pair<std::size_t, double> partial=saved_partial_bin(ms1["data"]);
+    EXPECT_EQ(merged.count(), mnb.bins().size()*mnb.num_elements()+partial.first);
+    EXPECT_LT(partial.first, mnb.num_elements());
+    double binned_sum=0;
+    for (std::size_t i=0; i<mnb.bins().size(); ++i) binned_sum+=mnb.bins()[i]*mnb.num_elements();
+    EXPECT_NEAR(total, binned_sum+partial.second, 1E-9);
+
+    // the merged accumulator keeps accumulating
+    for (int i=0; i<100; ++i) ms1["data"] << gen();
+    EXPECT_EQ(4104u, ms1["data"].count());
+    aa::result_set results(ms1);
+    EXPECT_NEAR(0.5, results["data"].mean<double>(), 0.05);
+}
+
+TEST(AccumulatorMergeFullBinning, BinsFromPartialBin) {
+    typedef aa::FullBinningAccumulator<double> named_type;
+    aa::accumulator_set ms1, ms2;
+    ms1 << named_type("data", aa::max_bin_number=8);
+    ms2 << named_type("data", aa::max_bin_number=8);
+    for (int i=0; i<39; ++i) ms1["data"] << 1.;
+    for (int i=0; i<39; ++i) ms2["data"] << 0.;
+    ms1.merge(ms2);
+
+    // each bin stands for exactly its number of samples
+    const named_type::accumulator_type& merged=ms1["data"].extract<named_type::accumulator_type>();
+    aa::max_num_binning_type<named_type::accumulator_type>::type mnb=merged.max_num_binning();
+    const std::pair<std::size_t, double> partial=saved_partial_bin(ms1["data"]);
+    EXPECT_EQ(78u, merged.count());
+    EXPECT_LE(mnb.bins().size(), 8u);
+    EXPECT_EQ(merged.count(), mnb.bins().size()*mnb.num_elements()+partial.first);
+    EXPECT_LT(partial.first, mnb.num_elements());
+    double binned_sum=0;
+    for (std::size_t i=0; i<mnb.bins().size(); ++i) binned_sum+=mnb.bins()[i]*mnb.num_elements();
+    EXPECT_NEAR(39., binned_sum+partial.second, 1E-12);
+}
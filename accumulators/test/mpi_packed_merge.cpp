@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file mpi_packed_merge.cpp
+    Test that merging a whole accumulator set, blocking or not, gives the same results as merging its accumulators one by one
+*/
+
+#include <cmath>
+#include <vector>
+
+#include "alps/utilities/mpi.hpp"
+
+#include "alps/config.hpp"
+#include "alps/accumulators.hpp"
+
+#include "alps/utilities/gtest_par_xml_output.hpp"
+#include "gtest/gtest.h"
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const int master=0;
+
+    double gen(int rank, int i) { return std::sin(0.7*i+rank)+0.5; }
+
+    // Fill the same observables in two sets; the number of samples differs between ranks
+    void fill(aa::accumulator_set& set1, aa::accumulator_set& set2, int rank) {
+        set1 << aa::MeanAccumulator<double>("mean")
+             << aa::NoBinningAccumulator<double>("nobin")
+             << aa::LogBinningAccumulator<double>("logbin")
+             << aa::FullBinningAccumulator<double>("fullbin")
+             << aa::FullBinningAccumulator< std::vector<double> >("fullbin_vec", aa::max_bin_number=16)
+             << aa::LogBinningAccumulator<float>("logbin_float")
+             << aa::NoBinningAccumulator<double>("unmeasured");
+        set2 << aa::MeanAccumulator<double>("mean")
+             << aa::NoBinningAccumulator<double>("nobin")
+             << aa::LogBinningAccumulator<double>("logbin")
+             << aa::FullBinningAccumulator<double>("fullbin")
+             << aa::FullBinningAccumulator< std::vector<double> >("fullbin_vec", aa::max_bin_number=16)
+             << aa::LogBinningAccumulator<float>("logbin_float")
+             << aa::NoBinningAccumulator<double>("unmeasured");
+
+        const int n=1000+317*rank;
+        for (int i=0; i<n; ++i) {
+            const double x=gen(rank, i);
+            const char* names[]={ "mean", "nobin", "logbin", "fullbin" };
+            for (int k=0; k<4; ++k) {
+                set1[names[k]] << x;
+                set2[names[k]] << x;
+            }
+            set1["fullbin_vec"] << std::vector<double>(3, x);
+            set2["fullbin_vec"] << std::vector<double>(3, x);
+            set1["logbin_float"] << float(x);
+            set2["logbin_float"] << float(x);
+        }
+    }
+}
+
+TEST(AccumulatorPackedMerge, SameAsIndividualMerges) {
+    alps::mpi::communicator comm;
+    aa::accumulator_set packed, individual;
+    fill(packed, individual, comm.rank());
+
+    if (comm.rank()==master) {
+        packed.collective_merge(comm, master);
+        for (aa::accumulator_set::iterator it=individual.begin(); it!=individual.end(); ++it) {
+            if (it->first!="unmeasured") it->second->collective_merge(comm, master);
+        }
+    } else {
+        const aa::accumulator_set& cpacked=packed;
+        cpacked.collective_merge(comm, master);
+        for (aa::accumulator_set::const_iterator it=individual.begin(); it!=individual.end(); ++it) {
+            const aa::accumulator_wrapper& acc=*it->second;
+            if (it->first!="unmeasured") acc.collective_merge(comm, master);
+        }
+    }
+    if (comm.rank()!=master) return;
+
+    aa::result_set rpacked(packed), rindividual(individual);
+    const char* names[]={ "mean", "nobin", "logbin", "fullbin" };
+    for (int k=0; k<4; ++k) {
+        EXPECT_EQ(rindividual[names[k]].count(), rpacked[names[k]].count()) << names[k];
+        EXPECT_NEAR(rindividual[names[k]].mean<double>(), rpacked[names[k]].mean<double>(), 1E-12) << names[k];
+        if (k>0) {
+            EXPECT_NEAR(rindividual[names[k]].error<double>(), rpacked[names[k]].error<double>(), 1E-12) << names[k];
+        }
+    }
+    EXPECT_NEAR(rindividual["logbin"].autocorrelation<double>(), rpacked["logbin"].autocorrelation<double>(), 1E-10);
+    EXPECT_NEAR(rindividual["logbin_float"].error<float>(), rpacked["logbin_float"].error<float>(), 1E-6);
+
+    typedef aa::FullBinningAccumulator<double>::accumulator_type full_type;
+    const full_type& full_packed=packed["fullbin"].extract<full_type>();
+    const full_type& full_individual=individual["fullbin"].extract<full_type>();
+    ASSERT_EQ(full_individual.max_num_binning().bins().size(), full_packed.max_num_binning().bins().size());
+    for (std::size_t i=0; i<full_packed.max_num_binning().bins().size(); ++i)
+        EXPECT_NEAR(full_individual.max_num_binning().bins()[i], full_packed.max_num_binning().bins()[i], 1E-12);
+
+    typedef std::vector<double> dvec;
+    const dvec epacked=rpacked["fullbin_vec"].error<dvec>(), eindividual=rindividual["fullbin_vec"].error<dvec>();
+    ASSERT_EQ(eindividual.size(), epacked.size());
+    for (std::size_t i=0; i<epacked.size(); ++i) EXPECT_NEAR(eindividual[i], epacked[i], 1E-12);
+
+    EXPECT_EQ(0u, rpacked["unmeasured"].count());
+}
+
+TEST(AccumulatorPackedMerge, MeasuredOnSomeRanks) {
+    alps::mpi::communicator comm;
+    if (comm.size()<2) return;
+    aa::accumulator_set mset;
+    mset << aa::NoBinningAccumulator<double>("partly");
+    if (comm.rank()==1) mset["partly"] << 1.;
+
+    if (comm.rank()==master) {
+        EXPECT_THROW(mset.collective_merge(comm, master), std::runtime_error);
+    } else {
+        const aa::accumulator_set& cset=mset;
+        EXPECT_THROW(cset.collective_merge(comm, master), std::runtime_error);
+    }
+}
+
+#if MPI_VERSION >= 3
+TEST(AccumulatorPackedMerge, NonBlockingSameAsBlocking) {
+    alps::mpi::communicator comm;
+    aa::accumulator_set sampled, blocking;
+    fill(sampled, blocking, comm.rank());
+    const std::size_t count=sampled["fullbin"].count();
+
+    aa::accumulator_set::pending_merge merge=sampled.start_collective_merge(comm, master);
+    // sampling continues while the merge proceeds, without changing its result
+    int nextra=0;
+    while (!merge.test()) {
+        sampled["fullbin"] << 1.;
+        ++nextra;
+    }
+    merge.wait();
+    EXPECT_EQ(count+nextra, sampled["fullbin"].count());
+
+    if (comm.rank()==master) {
+        blocking.collective_merge(comm, master);
+        aa::accumulator_set merged;
+        merge.get(merged);
+        EXPECT_EQ(blocking.size(), merged.size());
+        aa::result_set rmerged(merged), rblocking(blocking);
+        const char* names[]={ "mean", "nobin", "logbin", "fullbin", "logbin_float" };
+        for (int k=0; k<5; ++k) {
+            EXPECT_EQ(rblocking[names[k]].count(), rmerged[names[k]].count()) << names[k];
+            EXPECT_NEAR(rblocking[names[k]].mean<double>(), rmerged[names[k]].mean<double>(), 1E-12) << names[k];
+        }
+        // the non-blocking reduction may sum in a different order
+        EXPECT_NEAR(rblocking["fullbin"].error<double>(), rmerged["fullbin"].error<double>(), 1E-12);
+        EXPECT_NEAR(rblocking["fullbin_vec"].error< std::vector<double> >()[1], rmerged["fullbin_vec"].error< std::vector<double> >()[1], 1E-12);
+        EXPECT_EQ(0u, rmerged["unmeasured"].count());
+    } else {
+        const aa::accumulator_set& cblocking=blocking;
+        cblocking.collective_merge(comm, master);
+        aa::accumulator_set merged;
+        EXPECT_THROW(merge.get(merged), std::runtime_error);
+    }
+}
+
+TEST(AccumulatorPackedMerge, NonBlockingMeasuredOnSomeRanks) {
+    alps::mpi::communicator comm;
+    if (comm.size()<2) return;
+    aa::accumulator_set mset;
+    mset << aa::NoBinningAccumulator<double>("partly");
+    if (comm.rank()==1) mset["partly"] << 1.;
+
+    aa::accumulator_set::pending_merge merge=mset.start_collective_merge(comm, master);
+    EXPECT_THROW(merge.wait(), std::runtime_error);
+    EXPECT_TRUE(merge.test());
+}
+#endif
+
+int main(int argc, char** argv)
+{
+   alps::mpi::environment env(argc, argv, false);
+   alps::gtest_par_xml_output tweak;
+   tweak(alps::mpi::communicator().rank(), argc, argv);
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file mpi_ratio_merge.cpp
+    Test the collective merge of ratio_accumulator_set against merging the sets of all ranks on one process
+*/
+
+#include <cmath>
+#include <vector>
+
+#include "alps/utilities/mpi.hpp"
+
+#include "alps/config.hpp"
+#include "alps/accumulators.hpp"
+
+#include "alps/utilities/gtest_par_xml_output.hpp"
+#include "gtest/gtest.h"
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const int master=0;
+
+    double sign(int i) { return std::sin(1.3*i) > -0.3 ? 1. : -1.; }
+
+    // The ranks have different numbers of samples, and so different bin sizes
+    void fill(aa::ratio_accumulator_set& set, int rank) {
+        const int first=1000*rank*(rank+1)/2, last=first+1000*(rank+1);
+        std::vector<double> v(3);
+        for (int i=first; i<last; ++i) {
+            set.sign(sign(i));
+            set["energy"] << std::sin(0.37*i)+0.5;
+            for (std::size_t j=0; j<v.size(); ++j) v[j]=std::cos(0.11*i+j);
+            set["green"] << v;
+        }
+    }
+}
+
+TEST(MpiRatioMerge, SameAsSerialMerge) {
+    alps::mpi::communicator comm;
+    aa::ratio_accumulator_set set(16);
+    fill(set, comm.rank());
+    set.collective_merge(comm, master);
+    if (comm.rank()!=master) {
+        aa::ratio_accumulator_set local(16);
+        fill(local, comm.rank());
+        EXPECT_EQ(local.count(), set.count());
+        return;
+    }
+
+    aa::ratio_accumulator_set expected(16);
+    for (int rank=0; rank<comm.size(); ++rank) {
+        aa::ratio_accumulator_set other(16);
+        fill(other, rank);
+        expected.merge(other);
+    }
+    EXPECT_EQ(expected.count(), set.count());
+    EXPECT_LE(set.bin_number(), 16u);
+    const char* names[]={"energy", "green"};
+    for (std::size_t n=0; n<2; ++n) {
+        aa::ratio_result const lhs=expected.result(names[n]), rhs=set.result(names[n]);
+        ASSERT_EQ(lhs.mean().size(), rhs.mean().size());
+        for (std::size_t i=0; i<lhs.mean().size(); ++i) {
+            EXPECT_NEAR(lhs.mean()[i], rhs.mean()[i], 1E-12);
+            if (comm.size()>1)
+                EXPECT_TRUE(std::isfinite(rhs.error()[i]));
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+   alps::mpi::environment env(argc, argv, false);
+   alps::gtest_par_xml_output tweak;
+   tweak(alps::mpi::communicator().rank(), argc, argv);
+   ::testing::InitGoogleTest(&argc, argv);
+   return RUN_ALL_TESTS();
+}
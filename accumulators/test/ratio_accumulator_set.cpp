@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file ratio_accumulator_set.cpp
+    Test the sign-weighted ratio estimates of ratio_accumulator_set against a direct jackknife
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    double sign(int i) { return std::sin(1.3*i) > -0.3 ? 1. : -1.; }
+    double energy(int i) { return std::sin(0.37*i)+0.5; }
+    std::vector<double> green(int i) {
+        std::vector<double> v(3);
+        for (std::size_t j=0; j<v.size(); ++j) v[j]=std::cos(0.11*i+j);
+        return v;
+    }
+
+    /// Adds the samples [first, last); "sparse" is measured in every third sample only
+    void add(aa::ratio_accumulator_set& set, int first, int last) {
+        for (int i=first; i<last; ++i) {
+            set.sign(sign(i));
+            set["energy"] << energy(i);
+            set["green"] << green(i);
+            if (i%3==0) set["sparse"] << energy(i);
+        }
+    }
+
+    /// Ratio and jackknife error over consecutive bins of `bin_size` samples, from the samples themselves
+    void direct_estimate(int nsamples, std::size_t bin_size, double (*obs)(int), double& mean, double& error) {
+        double num=0, den=0;
+        for (int i=0; i<nsamples; ++i) {
+            num+=sign(i)*obs(i);
+            den+=sign(i);
+        }
+        mean=num/den;
+
+        const std::size_t nbins=nsamples/bin_size;
+        std::vector<double> num_bins(nbins), den_bins(nbins);
+        double num_total=0, den_total=0;
+        for (std::size_t k=0; k<nbins; ++k) {
+            for (std::size_t i=k*bin_size; i<(k+1)*bin_size; ++i) {
+                num_bins[k]+=sign(i)*obs(i);
+                den_bins[k]+=sign(i);
+            }
+            num_total+=num_bins[k];
+            den_total+=den_bins[k];
+        }
+        std::vector<double> jack(nbins);
+        double jack_mean=0;
+        for (std::size_t k=0; k<nbins; ++k) {
+            jack[k]=(num_total-num_bins[k])/(den_total-den_bins[k]);
+            jack_mean+=jack[k]/nbins;
+        }
+        double var=0;
+        for (std::size_t k=0; k<nbins; ++k) var+=(jack[k]-jack_mean)*(jack[k]-jack_mean);
+        error=std::sqrt(var*(nbins-1)/nbins);
+    }
+
+    double sparse_energy(int i) { return i%3==0 ? energy(i) : 0.; }
+
+    void expect_equal(aa::ratio_result const& lhs, aa::ratio_result const& rhs) {
+        EXPECT_EQ(lhs.count(), rhs.count());
+        ASSERT_EQ(lhs.mean().size(), rhs.mean().size());
+        for (std::size_t i=0; i<lhs.mean().size(); ++i) {
+            EXPECT_NEAR(lhs.mean()[i], rhs.mean()[i], 1E-12*std::fabs(lhs.mean()[i]));
+            EXPECT_NEAR(lhs.error()[i], rhs.error()[i], 1E-10*lhs.error()[i]);
+        }
+    }
+}
+
+class RatioAccumulatorSetTest : public ::testing::TestWithParam<int> {};
+
+TEST_P(RatioAccumulatorSetTest, SameAsDirectJackknife) {
+    const int nsamples=GetParam();
+    aa::ratio_accumulator_set set(16);
+    add(set, 0, nsamples);
+
+    EXPECT_EQ(nsamples, set.count());
+    EXPECT_LE(set.bin_number(), 16u);
+
+    double mean, error;
+    direct_estimate(nsamples, set.bin_size(), energy, mean, error);
+    aa::ratio_result const energy_result=set.result("energy");
+    EXPECT_NEAR(mean, energy_result.mean()[0], 1E-12);
+    EXPECT_NEAR(error, energy_result.error()[0], 1E-10);
+
+    direct_estimate(nsamples, set.bin_size(), sparse_energy, mean, error);
+    aa::ratio_result const sparse_result=set.result("sparse");
+    EXPECT_NEAR(mean, sparse_result.mean()[0], 1E-12);
+    EXPECT_NEAR(error, sparse_result.error()[0], 1E-10);
+
+    EXPECT_EQ(3u, set.result("green").mean().size());
+}
+
+INSTANTIATE_TEST_CASE_P(RatioAccumulatorSet, RatioAccumulatorSetTest, ::testing::Values(1000, 1024, 4099));
+
+TEST(RatioAccumulatorSet, FewBins) {
+    aa::ratio_accumulator_set set;
+    set.sign(1.);
+    set["energy"] << 2.;
+    aa::ratio_result const result=set.result("energy");
+    EXPECT_EQ(2., result.mean()[0]);
+    EXPECT_TRUE(std::isinf(result.error()[0]));
+}
+
+TEST(RatioAccumulatorSet, Merge) {
+    aa::ratio_accumulator_set whole(16), lhs(16), rhs(16);
+    add(whole, 0, 3000);
+    add(lhs, 0, 1000);
+    add(rhs, 1000, 3000);
+    lhs.merge(rhs);
+
+    EXPECT_EQ(whole.count(), lhs.count());
+    EXPECT_EQ(whole.bin_size(), lhs.bin_size());
+    EXPECT_LE(lhs.bin_number(), 16u);
+    const char* names[]={"energy", "green", "sparse"};
+    for (std::size_t n=0; n<3; ++n) {
+        aa::ratio_result const expected=whole.result(names[n]), merged=lhs.result(names[n]);
+        for (std::size_t i=0; i<expected.mean().size(); ++i) {
+            EXPECT_NEAR(expected.mean()[i], merged.mean()[i], 1E-12);
+            // the bins are of other samples, but estimate the same error
+            EXPECT_NEAR(expected.error()[i], merged.error()[i], 0.5*expected.error()[i]);
+        }
+    }
+}
+
+TEST(RatioAccumulatorSet, MergeObservableOfOneSet) {
+    aa::ratio_accumulator_set lhs, rhs;
+    lhs.sign(1.);
+    lhs["a"] << 3.;
+    rhs.sign(1.);
+    rhs["b"] << 5.;
+    rhs.sign(-1.);
+    lhs.merge(rhs);
+    EXPECT_EQ(3u, lhs.count());
+    EXPECT_EQ(3., lhs.result("a").mean()[0]);
+    EXPECT_EQ(5., lhs.result("b").mean()[0]);
+}
+
+TEST(RatioAccumulatorSet, SaveLoad) {
+    alps::testing::unique_file ufile("ratio_accumulator_set.h5.", alps::testing::unique_file::REMOVE_AFTER);
+    aa::ratio_accumulator_set set(16);
+    add(set, 0, 1000);
+    {
+        alps::hdf5::archive ar(ufile.name(), "w");
+        ar["ratios"] << set;
+    }
+    aa::ratio_accumulator_set loaded;
+    {
+        alps::hdf5::archive ar(ufile.name(), "r");
+        ar["ratios"] >> loaded;
+    }
+    EXPECT_EQ(set.max_bin_number(), loaded.max_bin_number());
+    EXPECT_EQ(set.names(), loaded.names());
+    expect_equal(set.result("energy"), loaded.result("energy"));
+    expect_equal(set.result("green"), loaded.result("green"));
+    expect_equal(set.sign_result(), loaded.sign_result());
+
+    // the loaded set goes on accumulating
+    add(set, 1000, 1100);
+    add(loaded, 1000, 1100);
+    expect_equal(set.result("sparse"), loaded.result("sparse"));
+}
+
+TEST(RatioAccumulatorSet, Errors) {
+    aa::ratio_accumulator_set set;
+    EXPECT_THROW(set["energy"] << 1., std::logic_error);
+    set.sign(1.);
+    set["green"] << green(0);
+    EXPECT_THROW(set["green"] << 1., std::runtime_error);
+    EXPECT_THROW(set["green"] << std::vector<double>(), std::runtime_error);
+    EXPECT_THROW(set.result("energy"), std::out_of_range);
+}
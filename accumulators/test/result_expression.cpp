@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file result_expression.cpp
+    Test that deferred expressions of results give the same results as the operators of result_wrapper
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/accumulators/result_expression.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+class ResultExpressionTest : public ::testing::Test {
+  public:
+    aa::accumulator_set measurements;
+    aa::result_set results;
+
+    ResultExpressionTest(): measurements(), results(fill(measurements)) {}
+
+    static aa::accumulator_set& fill(aa::accumulator_set& measurements) {
+        measurements << aa::FullBinningAccumulator<double>("m2")
+                     << aa::FullBinningAccumulator<double>("m4")
+                     << aa::FullBinningAccumulator<double>("few_bins", aa::max_bin_number=16)
+                     << aa::FullBinningAccumulator< std::vector<double> >("vector")
+                     << aa::NoBinningAccumulator<double>("nobin");
+        for (int i=0; i<10000; ++i) {
+            const double m=std::sin(0.37*i)+0.1*std::cos(1.3*i);
+            measurements["m2"] << m*m;
+            measurements["m4"] << m*m*m*m;
+            measurements["few_bins"] << m;
+            measurements["vector"] << std::vector<double>(2, m*m);
+            measurements["nobin"] << m*m;
+        }
+        return measurements;
+    }
+
+    static void expect_same_full(aa::result_wrapper const& expected, aa::result_wrapper const& value) {
+        typedef aa::FullBinningAccumulator<double>::result_type full_type;
+        EXPECT_EQ(expected.count(), value.count());
+        EXPECT_EQ(expected.mean<double>(), value.mean<double>());
+        EXPECT_EQ(expected.error<double>(), value.error<double>());
+        const std::vector<double>& expected_bins=expected.extract<full_type>().get_bins();
+        const std::vector<double>& bins=value.extract<full_type>().get_bins();
+        EXPECT_EQ(expected_bins, bins);
+    }
+};
+
+TEST_F(ResultExpressionTest, BinderCumulant) {
+    const aa::result_wrapper& m2=results["m2"];
+    const aa::result_wrapper& m4=results["m4"];
+    const aa::result_wrapper expected=1-m4/(3*m2*m2);
+    const aa::result_wrapper value=1-aa::lazy(m4)/(3*aa::lazy(m2)*aa::lazy(m2));
+    expect_same_full(expected, value);
+
+    // the jackknife bins are kept in the operands
+    typedef aa::FullBinningAccumulator<double>::result_type full_type;
+    EXPECT_EQ(m2.extract<full_type>().get_bins().size()+1, m2.extract<full_type>().get_jackknife_bins().size());
+}
+
+TEST_F(ResultExpressionTest, MixedOperands) {
+    const aa::result_wrapper& m2=results["m2"];
+    const aa::result_wrapper& m4=results["m4"];
+    expect_same_full((m2-m4*2.5)/m2+0.5, (aa::lazy(m2)-m4*2.5)/m2+0.5);
+    expect_same_full(m4/(m2*m2), m4/(aa::lazy(m2)*m2));
+    expect_same_full(2/m2-m4, 2/aa::lazy(m2)-m4);
+    // a temporary result is kept by the expression
+    aa::result_expression expression=aa::lazy(m2)*(m4*2.);
+    expect_same_full(m2*(m4*2.), expression);
+}
+
+TEST_F(ResultExpressionTest, Functions) {
+    const aa::result_wrapper& m2=results["m2"];
+    const aa::result_wrapper& m4=results["m4"];
+    expect_same_full(sqrt(m4)/m2, sqrt(aa::lazy(m4))/m2);
+    expect_same_full(-log(m2)+sq(m2), -log(aa::lazy(m2))+sq(aa::lazy(m2)));
+    expect_same_full(m2.inverse().sin(), aa::lazy(m2).inverse().sin());
+}
+
+TEST_F(ResultExpressionTest, OtherResults) {
+    // evaluated operation by operation
+    const aa::result_wrapper& v=results["vector"];
+    const aa::result_wrapper expected=v*v+2.;
+    const aa::result_wrapper value=aa::lazy(v)*v+2.;
+    EXPECT_EQ(expected.mean< std::vector<double> >(), value.mean< std::vector<double> >());
+    EXPECT_EQ(expected.error< std::vector<double> >(), value.error< std::vector<double> >());
+
+    const aa::result_wrapper& nobin=results["nobin"];
+    const aa::result_wrapper nobin_value=1/aa::lazy(nobin)-nobin;
+    const aa::result_wrapper nobin_expected=1/nobin-nobin;
+    EXPECT_EQ(nobin_expected.mean<double>(), nobin_value.mean<double>());
+    EXPECT_EQ(nobin_expected.error<double>(), nobin_value.error<double>());
+}
+
+TEST_F(ResultExpressionTest, UnequalBins) {
+    aa::result_expression expression=aa::lazy(results["m2"])*results["few_bins"];
+    EXPECT_THROW(expression.evaluate(), std::runtime_error);
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file sharded_accumulator_set.cpp
+    Test recording into a sharded accumulator set from several threads
+*/
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    const std::size_t nshards=4;
+    const int nsamples=5000;
+
+    double gen(std::size_t shard, int i) { return std::sin(0.1*i+shard)+0.5; }
+
+    void fill_prototype(aa::accumulator_set& prototype) {
+        prototype << aa::MeanAccumulator<double>("mean")
+                  << aa::LogBinningAccumulator<double>("log")
+                  << aa::FullBinningAccumulator<double>("full")
+                  << aa::NoBinningAccumulator< std::vector<double> >("vector");
+    }
+
+    bool record(aa::sharded_accumulator_set& shards, std::size_t ishard) {
+        aa::accumulator_set& shard=shards.shard(ishard);
+        aa::accumulator_handle< aa::FullBinningAccumulator<double> > full
+            =shard.handle< aa::FullBinningAccumulator<double> >("full");
+        std::vector<double> v(3);
+        for (int i=0; i<nsamples; ++i) {
+            const double x=gen(ishard, i);
+            shard["mean"] << x;
+            shard["log"] << x;
+            full << x;
+            v.assign(v.size(), x);
+            shard["vector"] << v;
+        }
+        return true;
+    }
+
+    void record_concurrently(aa::sharded_accumulator_set& shards) {
+        std::vector< std::future<bool> > futures;
+        for (std::size_t i=0; i<shards.size(); ++i)
+            futures.push_back(std::async(std::launch::async, record, std::ref(shards), i));
+        for (std::size_t i=0; i<futures.size(); ++i)
+            EXPECT_TRUE(futures[i].get()) << "Thread " << i << " failed";
+    }
+}
+
+TEST(ShardedAccumulatorSet, SameAsSerialMerge) {
+    aa::accumulator_set prototype;
+    fill_prototype(prototype);
+    aa::sharded_accumulator_set shards(prototype, nshards);
+    record_concurrently(shards);
+
+    aa::accumulator_set merged;
+    shards.reduce(merged);
+    EXPECT_EQ(prototype.size(), merged.size());
+
+    // the same samples recorded and merged in shard order in a single thread
+    aa::sharded_accumulator_set serial(prototype, nshards);
+    for (std::size_t i=0; i<nshards; ++i) record(serial, i);
+    aa::accumulator_set expected;
+    fill_prototype(expected);
+    for (std::size_t i=0; i<nshards; ++i) expected.merge(serial.shard(i));
+
+    const char* names[]={ "mean", "log", "full" };
+    for (std::size_t n=0; n<3; ++n) {
+        EXPECT_EQ(nshards*nsamples, merged[names[n]].count()) << names[n];
+        EXPECT_EQ(expected[names[n]].mean<double>(), merged[names[n]].mean<double>()) << names[n];
+    }
+    EXPECT_EQ(expected["vector"].mean< std::vector<double> >(), merged["vector"].mean< std::vector<double> >());
+
+    aa::result_set expected_results(expected);
+    aa::result_set results(merged);
+    EXPECT_EQ(expected_results["log"].error<double>(), results["log"].error<double>());
+    EXPECT_EQ(expected_results["full"].error<double>(), results["full"].error<double>());
+
+    // the prototype is not modified
+    EXPECT_EQ(0u, prototype["mean"].count());
+}
+
+TEST(ShardedAccumulatorSet, Reproducible) {
+    aa::accumulator_set prototype;
+    fill_prototype(prototype);
+    aa::sharded_accumulator_set shards1(prototype, nshards), shards2(prototype, nshards);
+    record_concurrently(shards1);
+    record_concurrently(shards2);
+
+    aa::accumulator_set merged1, merged2;
+    shards1.reduce(merged1);
+    shards2.reduce(merged2);
+    EXPECT_EQ(merged1["full"].mean<double>(), merged2["full"].mean<double>());
+
+    aa::result_set results1(merged1), results2(merged2);
+    EXPECT_EQ(results1["full"].error<double>(), results2["full"].error<double>());
+    EXPECT_EQ(results1["vector"].error< std::vector<double> >(), results2["vector"].error< std::vector<double> >());
+
+    // reducing twice gives the same result
+    shards1.reduce(merged2);
+    EXPECT_EQ(merged1["log"].mean<double>(), merged2["log"].mean<double>());
+}
+
+TEST(ShardedAccumulatorSet, EmptyShards) {
+    aa::accumulator_set prototype;
+    fill_prototype(prototype);
+    aa::sharded_accumulator_set shards(prototype, nshards);
+    record(shards, 2);
+
+    aa::accumulator_set merged;
+    shards.reduce(merged);
+    EXPECT_EQ(static_cast<std::size_t>(nsamples), merged["vector"].count());
+    EXPECT_EQ(shards.shard(2)["vector"].mean< std::vector<double> >(), merged["vector"].mean< std::vector<double> >());
+    EXPECT_EQ(shards.shard(2)["full"].mean<double>(), merged["full"].mean<double>());
+
+    shards.reset();
+    EXPECT_EQ(0u, shards.shard(2)["full"].count());
+    EXPECT_THROW(aa::sharded_accumulator_set(prototype, 0), std::invalid_argument);
+}
+
+TEST(ShardedAccumulatorSet, NonEmptyPrototype) {
+    aa::accumulator_set prototype;
+    fill_prototype(prototype);
+    for (int i=0; i<10; ++i) prototype["mean"] << 100.;
+    aa::sharded_accumulator_set shards(prototype, nshards);
+    for (std::size_t i=0; i<nshards; ++i) EXPECT_EQ(0u, shards.shard(i)["mean"].count());
+    record_concurrently(shards);
+
+    // the samples of the prototype are neither in the shards nor in their merge
+    aa::accumulator_set merged;
+    shards.reduce(merged);
+    EXPECT_EQ(nshards*nsamples, merged["mean"].count());
+    EXPECT_EQ(10u, prototype["mean"].count());
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file static_accumulator_set.cpp
+    Test that the statically typed set behaves like, and is interchangeable with, accumulator_set
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+typedef aa::static_accumulator_set<
+    aa::MeanAccumulator<double>,
+    aa::FullBinningAccumulator<double>,
+    aa::LogBinningAccumulator< std::vector<double> >
+    > static_set;
+
+class StaticAccumulatorSetTest : public ::testing::Test {
+  public:
+    static_set sset;
+    aa::accumulator_set dset;
+
+    StaticAccumulatorSetTest()
+        : sset(aa::MeanAccumulator<double>("mean"),
+               aa::FullBinningAccumulator<double>("full", aa::max_bin_number=32),
+               aa::LogBinningAccumulator< std::vector<double> >("vector"))
+    {
+        dset << aa::MeanAccumulator<double>("mean")
+             << aa::FullBinningAccumulator<double>("full", aa::max_bin_number=32)
+             << aa::LogBinningAccumulator< std::vector<double> >("vector");
+    }
+
+    void fill(int n) {
+        std::vector<double> v(3);
+        for (int i=0; i<n; ++i) {
+            const double x=std::sin(0.3*i)+0.5;
+            v.assign(v.size(), x);
+            sset.get<0>()(x);
+            sset.get<1>()(x);
+            sset.get<2>()(v);
+            dset["mean"] << x;
+            dset["full"] << x;
+            dset["vector"] << v;
+        }
+    }
+
+    void expect_same(aa::result_set const& results, aa::result_set const& expected) {
+        EXPECT_EQ(expected.size(), results.size());
+        EXPECT_EQ(expected["mean"].mean<double>(), results["mean"].mean<double>());
+        EXPECT_EQ(expected["full"].count(), results["full"].count());
+        EXPECT_EQ(expected["full"].error<double>(), results["full"].error<double>());
+        EXPECT_EQ(expected["vector"].error< std::vector<double> >(), results["vector"].error< std::vector<double> >());
+    }
+};
+
+TEST_F(StaticAccumulatorSetTest, Names) {
+    EXPECT_EQ(3u, static_set::size());
+    EXPECT_EQ("full", sset.name(1));
+    EXPECT_EQ(2u, sset.index("vector"));
+    EXPECT_THROW(sset.index("nonexistent"), std::out_of_range);
+    EXPECT_EQ(32u, sset.get<1>().max_num_binning().max_number());
+}
+
+TEST_F(StaticAccumulatorSetTest, SameResults) {
+    fill(1000);
+    aa::result_set sresults;
+    sset.insert_results(sresults);
+    aa::result_set dresults(dset);
+    expect_same(sresults, dresults);
+
+    aa::accumulator_set converted;
+    sset.insert_accumulators(converted);
+    aa::result_set cresults(converted);
+    expect_same(cresults, dresults);
+    // the accumulators are copied
+    converted["mean"] << 1.;
+    EXPECT_EQ(1000u, sset.get<0>().count());
+}
+
+TEST_F(StaticAccumulatorSetTest, MergeAndReset) {
+    fill(500);
+    static_set other(sset);
+    sset.merge(other);
+    EXPECT_EQ(1000u, sset.get<1>().count());
+    EXPECT_EQ(1000u, sset.get<2>().count());
+
+    sset.reset();
+    EXPECT_EQ(0u, sset.get<0>().count());
+    EXPECT_EQ(0u, sset.get<1>().count());
+}
+
+TEST_F(StaticAccumulatorSetTest, SameArchiveLayout) {
+    const std::string h5name=alps::testing::temporary_filename("static_set.h5.");
+    fill(700);
+    {
+        alps::hdf5::archive ar(h5name, "w");
+        ar["static"] << sset;
+        ar["dynamic"] << dset;
+    }
+
+    // each kind of set reads the archive written by the other
+    static_set sloaded(aa::MeanAccumulator<double>("mean"),
+                       aa::FullBinningAccumulator<double>("full"),
+                       aa::LogBinningAccumulator< std::vector<double> >("vector"));
+    aa::accumulator_set dloaded;
+    {
+        alps::hdf5::archive ar(h5name, "r");
+        ar["dynamic"] >> sloaded;
+        ar["static"] >> dloaded;
+    }
+    aa::result_set expected(dset);
+
+    aa::result_set sresults;
+    sloaded.insert_results(sresults);
+    expect_same(sresults, expected);
+
+    aa::result_set dresults(dloaded);
+    expect_same(dresults, expected);
+}
+
+TEST_F(StaticAccumulatorSetTest, EmptyAccumulatorsAreNotSaved) {
+    const std::string h5name=alps::testing::temporary_filename("static_set.h5.");
+    sset.get<0>()(1.);
+    {
+        alps::hdf5::archive ar(h5name, "w");
+        ar["static"] << sset;
+    }
+    fill(10);
+    {
+        alps::hdf5::archive ar(h5name, "r");
+        EXPECT_FALSE(ar.is_group("static/full"));
+        ar["static"] >> sset;
+    }
+    EXPECT_EQ(1u, sset.get<0>().count());
+    EXPECT_EQ(0u, sset.get<1>().count());
+}
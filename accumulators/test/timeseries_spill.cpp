@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file timeseries_spill.cpp
+    Test streaming the time series of a FullBinningAccumulator to an HDF5 file
+*/
+
+#include <alps/accumulators.hpp>
+#include <alps/testing/unique_file.hpp>
+#include <alps/hdf5.hpp>
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace aa=alps::accumulators;
+
+namespace {
+    double gen(int i, int j) { return std::sin(0.37*i+j)+0.01*(i%13)*j; }
+
+    std::vector<double> gen_vector(int i) {
+        std::vector<double> v(3);
+        for (std::size_t j=0; j<v.size(); ++j) v[j]=gen(i, j);
+        return v;
+    }
+
+    typedef aa::FullBinningAccumulator<double> scalar_type;
+    typedef aa::FullBinningAccumulator< std::vector<double> > vector_type;
+}
+
+class TimeseriesSpillTest : public ::testing::Test {
+  public:
+    std::string spill_name;
+    std::string checkpoint_name;
+
+    TimeseriesSpillTest()
+        : spill_name(alps::testing::temporary_filename("spill.h5."))
+        , checkpoint_name(alps::testing::temporary_filename("spill_checkpoint.h5."))
+    {}
+
+    ~TimeseriesSpillTest() {
+        std::remove(spill_name.c_str());
+        std::remove(checkpoint_name.c_str());
+    }
+
+    template <typename T>
+    std::vector<T> read(std::string const& name) {
+        std::vector<T> data;
+        alps::hdf5::archive ar(spill_name, "r");
+        ar["/timeseries/"+ar.encode_segment(name)] >> data;
+        return data;
+    }
+};
+
+TEST_F(TimeseriesSpillTest, AllSamples) {
+    const int nsamples=1000;
+    {
+        aa::accumulator_set measurements;
+        measurements << scalar_type("E", aa::max_bin_number=16, aa::spill_file=spill_name);
+        for (int i=0; i<nsamples; ++i) measurements["E"] << gen(i, 0);
+        EXPECT_EQ(15u, measurements["E"].extract<scalar_type::accumulator_type>().max_num_binning().bins().size());
+    }
+    const std::vector<double> data=read<double>("E");
+    ASSERT_EQ(std::size_t(nsamples), data.size());
+    for (int i=0; i<nsamples; ++i) EXPECT_EQ(gen(i, 0), data[i]);
+}
+
+TEST_F(TimeseriesSpillTest, VectorBins) {
+    const int nsamples=1000, binsize=7;
+    {
+        aa::accumulator_set measurements;
+        measurements << vector_type("M/site", aa::spill_file=spill_name, aa::spill_bin_size=binsize);
+        for (int i=0; i<nsamples; ++i) measurements["M/site"] << gen_vector(i);
+    }
+    const std::vector< std::vector<double> > data=read< std::vector<double> >("M/site");
+    ASSERT_EQ(std::size_t(nsamples/binsize), data.size());
+    for (std::size_t b=0; b<data.size(); ++b) {
+        ASSERT_EQ(3u, data[b].size());
+        for (std::size_t j=0; j<3; ++j) {
+            double sum=0;
+            for (int i=b*binsize; i<int(b+1)*binsize; ++i) sum+=gen(i, j);
+            EXPECT_NEAR(sum/binsize, data[b][j], 1E-12);
+        }
+    }
+}
+
+TEST_F(TimeseriesSpillTest, ResetAndRestart) {
+    const int nsamples=500, binsize=3;
+    {
+        aa::accumulator_set measurements;
+        measurements << scalar_type("E", aa::spill_file=spill_name, aa::spill_bin_size=binsize);
+        // the thermalization is dropped from the file by the reset
+        for (int i=0; i<nsamples; ++i) measurements["E"] << -1.;
+        measurements.reset();
+        for (int i=0; i<nsamples; ++i) measurements["E"] << gen(i, 0);
+        {
+            alps::hdf5::archive ar(checkpoint_name, "w");
+            ar["measurements"] << measurements;
+        }
+        // bins of the samples after the checkpoint reach the file, but the run is restarted from the checkpoint
+        for (int i=0; i<nsamples; ++i) measurements["E"] << 100.;
+    }
+    {
+        aa::accumulator_set measurements;
+        measurements << scalar_type("E", aa::spill_file=spill_name, aa::spill_bin_size=binsize);
+        {
+            alps::hdf5::archive ar(checkpoint_name, "r");
+            ar["measurements"] >> measurements;
+        }
+        EXPECT_EQ(nsamples, measurements["E"].count());
+        for (int i=nsamples; i<2*nsamples; ++i) measurements["E"] << gen(i, 0);
+    }
+    const std::vector<double> data=read<double>("E");
+    ASSERT_EQ(std::size_t(2*nsamples/binsize), data.size());
+    for (std::size_t b=0; b<data.size(); ++b) {
+        double sum=0;
+        for (int i=b*binsize; i<int(b+1)*binsize; ++i) sum+=gen(i, 0);
+        EXPECT_NEAR(sum/binsize, data[b], 1E-12) << "bin " << b;
+    }
+}
+
+TEST_F(TimeseriesSpillTest, ShardsWriteOwnDatasets) {
+    const std::size_t nshards=3;
+    const int nsamples=100;
+    {
+        aa::accumulator_set prototype;
+        prototype << scalar_type("E", aa::spill_file=spill_name);
+        aa::sharded_accumulator_set shards(prototype, nshards);
+        // each shard claims a dataset when it first writes to the file, i.e., after 64 bins
+        for (std::size_t s=0; s<nshards; ++s)
+            for (int i=0; i<nsamples; ++i) shards.shard(s)["E"] << double(s);
+        aa::accumulator_set measurements;
+        shards.reduce(measurements);
+        EXPECT_EQ(nshards*nsamples, std::size_t(measurements["E"].count()));
+    }
+    const char* datasets[]={"E", "E.1", "E.2"};
+    for (std::size_t s=0; s<nshards; ++s) {
+        const std::vector<double> data=read<double>(datasets[s]);
+        ASSERT_EQ(std::size_t(nsamples), data.size()) << datasets[s];
+        for (int i=0; i<nsamples; ++i) EXPECT_EQ(double(s), data[i]);
+    }
+}
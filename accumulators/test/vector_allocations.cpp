@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file vector_allocations.cpp
+    Test that adding vector samples to a warmed-up accumulator does not allocate
+*/
+
+#include <alps/accumulators.hpp>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+    std::size_t allocation_count=0;
+}
+
+void* operator new(std::size_t sz) {
+    ++allocation_count;
+    void* p=std::malloc(sz ? sz : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+namespace aa=alps::accumulators;
+
+template <typename A>
+class AccumulatorVectorAllocationTest : public ::testing::Test {};
+
+typedef ::testing::Types<
+    aa::MeanAccumulator< std::vector<double> >,
+    aa::NoBinningAccumulator< std::vector<double> >,
+    aa::LogBinningAccumulator< std::vector<double> >,
+    aa::FullBinningAccumulator< std::vector<double> >
+    > test_types;
+
+TYPED_TEST_CASE(AccumulatorVectorAllocationTest, test_types);
+
+TYPED_TEST(AccumulatorVectorAllocationTest, NoAllocationsAfterWarmup) {
+    typedef std::vector<double> vtype;
+    aa::accumulator_set mset;
+    mset << TypeParam("data");
+    aa::accumulator_wrapper& acc=mset["data"];
+
+    vtype sample(100);
+    // 1000 samples: all binning levels up to 2^9 exist, the full-binning bins have been rebinned
+    for (int i=0; i<1000; ++i) {
+        sample.assign(sample.size(), 0.5+0.25*(i%7));
+        acc << sample;
+    }
+
+    // no new binning level or rebinning happens before sample 1024
+    const std::size_t before=allocation_count;
+    for (int i=1000; i<1020; ++i) {
+        sample.assign(sample.size(), 0.5+0.25*(i%7));
+        acc << sample;
+    }
+    EXPECT_EQ(before, allocation_count);
+    EXPECT_EQ(1020u, acc.count());
+}
@@ -229,6 +229,13 @@ macro(add_testing)
   endif (Testing)
 endmacro(add_testing)
 
+macro(add_benchmarks)
+  option(Benchmarks "Build microbenchmarks (requires Google Benchmark)" OFF)
+  if (Benchmarks)
+    add_subdirectory(benchmark)
+  endif (Benchmarks)
+endmacro(add_benchmarks)
+
 macro(gen_documentation)
   set(DOXYFILE_EXTRA_SOURCES "${DOXYFILE_EXTRA_SOURCES} ${PROJECT_SOURCE_DIR}/include ${PROJECT_SOURCE_DIR}/src" PARENT_SCOPE)
   option(Documentation "Build documentation" OFF)
@@ -0,0 +1,51 @@
+#
+# This cmake script adds microbenchmarks to a project from the 'benchmark' directory in the ALPS module
+#
+
+# Google Benchmark is not bundled: it has to be installed
+if (NOT benchmarks_are_already_enabled)
+    find_package(benchmark REQUIRED)
+    message(STATUS "Google Benchmark found: ${benchmark_DIR}")
+    set(benchmarks_are_already_enabled TRUE)
+endif(NOT benchmarks_are_already_enabled)
+
+# custom function to add a benchmark linked to Google Benchmark
+# arg0 - benchmark (assume the source is ${benchmark}.cpp); the target is named bench_${benchmark}
+# optional arg: NOMAIN: do not link benchmark_main; the benchmark has its own main() (e.g., to initialize MPI)
+# optional arg: PARTEST: run in parallel using N processes, where N is the run-time value of the environment
+#               variable ALPS_BENCHMARK_MPI_NPROC (or 1 if the variable is not set)
+# optional arg: SRCS source1 source2... : additional source files
+# Affected by: ${PROJECT_NAME}_DEPENDS variable.
+#
+# The target `run_benchmarks` runs all benchmarks; each writes its results in JSON
+# to bench_${benchmark}.json in its build directory, for comparison across versions.
+function(alps_add_benchmark benchmark)
+    include(CMakeParseArguments)
+    cmake_parse_arguments("arg" "NOMAIN;PARTEST" "" "SRCS" ${ARGN})
+    if (arg_UNPARSED_ARGUMENTS)
+        message(FATAL_ERROR
+            "Unknown parameters: ${arg_UNPARSED_ARGUMENTS}"
+            "Usage: alps_add_benchmark(benchmarkname [NOMAIN] [PARTEST] [SRCS extra_sources...])")
+    endif()
+    set(target_ bench_${benchmark})
+    add_executable(${target_} ${benchmark} ${arg_SRCS})
+    if (arg_NOMAIN)
+        set(link_benchmark_ benchmark::benchmark)
+    else()
+        set(link_benchmark_ benchmark::benchmark_main)
+    endif()
+    target_link_libraries(${target_} ${PROJECT_NAME} ${${PROJECT_NAME}_DEPENDS} ${link_benchmark_})
+
+    set(json_ ${CMAKE_CURRENT_BINARY_DIR}/${target_}.json)
+    # FIXME: in the MPI command, POSIX shell is assumed
+    if (arg_PARTEST AND MPIEXEC)
+        set(cmd_ "/bin/sh" "-c" "${MPIEXEC} ${MPIEXEC_NUMPROC_FLAG} \${ALPS_BENCHMARK_MPI_NPROC:-1} ${MPIEXEC_PREFLAGS} $<TARGET_FILE:${target_}> ${MPIEXEC_POSTFLAGS} --benchmark_out=${json_} --benchmark_out_format=json")
+    else()
+        set(cmd_ $<TARGET_FILE:${target_}> --benchmark_out=${json_} --benchmark_out_format=json)
+    endif()
+    add_custom_target(run_${target_} COMMAND ${cmd_} DEPENDS ${target_} VERBATIM)
+    if (NOT TARGET run_benchmarks)
+        add_custom_target(run_benchmarks)
+    endif()
+    add_dependencies(run_benchmarks run_${target_})
+endfunction(alps_add_benchmark)
@@ -191,6 +191,18 @@ namespace alps {
                     throw std::logic_error("Invalid type on path: " + path + ALPS_STACKTRACE);
                 }
 
+                /// Append the block `value` of extent `size` along the first dimension of the dataset `path`
+                /** A new dataset is created chunked, with chunks of extent `chunk` (default: `size`),
+                    and unlimited in its first dimension; the other dimensions of later blocks must match. */
+                template<typename T> void append(
+                      std::string path
+                    , T const * value
+                    , std::vector<std::size_t> size
+                    , std::vector<std::size_t> chunk = std::vector<std::size_t>()
+                ) const {
+                    throw std::logic_error("Invalid type on path: " + path + ALPS_STACKTRACE);
+                }
+
                 #define ALPS_HDF5_DEFINE_API(T)                                                                                                                        \
                     void read(std::string path, T & value) const;                                                                                                      \
                     void read(                                                                                                                                         \
@@ -206,7 +218,9 @@ namespace alps {
                         , T const * value, std::vector<std::size_t> size                                                                                               \
                         , std::vector<std::size_t> chunk = std::vector<std::size_t>()                                                                                  \
                         , std::vector<std::size_t> offset = std::vector<std::size_t>()                                                                                 \
-                    ) const;
+                    ) const;                                                                                                                                           \
+                                                                                                                                                                       \
+                    void append(std::string path, T const * value, std::vector<std::size_t> size, std::vector<std::size_t> chunk = std::vector<std::size_t>()) const;
                 ALPS_FOREACH_NATIVE_HDF5_TYPE(ALPS_HDF5_DEFINE_API)
                 #undef ALPS_HDF5_DEFINE_API
 
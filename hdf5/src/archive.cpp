@@ -1201,6 +1201,72 @@ namespace alps {
         ALPS_FOREACH_NATIVE_HDF5_TYPE(ALPS_HDF5_WRITE_VECTOR)
         #undef ALPS_HDF5_WRITE_VECTOR
 
+        #define ALPS_HDF5_APPEND_VECTOR(T)                                                                                                                              \
+            void archive::append(std::string path, T const * value, std::vector<std::size_t> size, std::vector<std::size_t> chunk) const {                              \
+                ALPS_HDF5_FAKE_THREADSAFETY                                                                                                                             \
+                if (context_ == NULL)                                                                                                                                   \
+                    throw archive_closed("the archive is closed" + ALPS_STACKTRACE);                                                                                    \
+                if (!context_->write_)                                                                                                                                  \
+                    throw archive_error("the archive is not writeable" + ALPS_STACKTRACE);                                                                              \
+                if ((path = complete_path(path)).find_last_of('@') != std::string::npos)                                                                                \
+                    throw invalid_path("attributes cannot be appended to: " + path + ALPS_STACKTRACE);                                                                  \
+                if (size.size() == 0 || size[0] == 0)                                                                                                                   \
+                    throw archive_error("no block passed to append to path: " + path + ALPS_STACKTRACE);                                                                \
+                if (chunk.size() == 0)                                                                                                                                  \
+                    chunk = size;                                                                                                                                       \
+                if (chunk.size() != size.size())                                                                                                                        \
+                    throw archive_error("wrong chunk passed for path: " + path + ALPS_STACKTRACE);                                                                      \
+                std::vector<hsize_t> size_hid(size.begin(), size.end()), chunk_hid(chunk.begin(), chunk.end()), offset_hid(size.size(), 0), extent_hid(size_hid);       \
+                detail::type_type type_id(detail::get_native_type(alps::detail::type_wrapper< T >::type()));                                                            \
+                bool created = false;                                                                                                                                   \
+                hid_t data_id = H5Dopen2(context_->file_id_, path.c_str(), H5P_DEFAULT);                                                                                \
+                if (data_id < 0) {                                                                                                                                      \
+                    if (path.find_last_of('/') < std::string::npos && path.find_last_of('/') > 0)                                                                       \
+                        create_group(path.substr(0, path.find_last_of('/')));                                                                                           \
+                    std::vector<hsize_t> max_hid(size_hid);                                                                                                             \
+                    max_hid[0] = H5S_UNLIMITED;                                                                                                                         \
+                    detail::property_type prop_id(H5Pcreate(H5P_DATASET_CREATE));                                                                                       \
+                    detail::check_error(H5Pset_attr_creation_order(prop_id, (H5P_CRT_ORDER_TRACKED | H5P_CRT_ORDER_INDEXED)));                                          \
+                    detail::check_error(H5Pset_chunk(prop_id, static_cast<int>(chunk_hid.size()), &chunk_hid.front()));                                                 \
+                    detail::check_error(data_id = H5Dcreate2(                                                                                                           \
+                          context_->file_id_                                                                                                                            \
+                        , path.c_str()                                                                                                                                  \
+                        , type_id                                                                                                                                       \
+                        , detail::space_type(H5Screate_simple(static_cast<int>(size_hid.size()), &size_hid.front(), &max_hid.front()))                                  \
+                        , H5P_DEFAULT                                                                                                                                   \
+                        , prop_id                                                                                                                                       \
+                        , H5P_DEFAULT                                                                                                                                   \
+                    ));                                                                                                                                                 \
+                    created = true;                                                                                                                                     \
+                }                                                                                                                                                       \
+                detail::data_type raii_id(data_id);                                                                                                                     \
+                if (!created) {                                                                                                                                         \
+                    std::vector<hsize_t> current_hid(size.size()), max_hid(size.size());                                                                                \
+                    {                                                                                                                                                   \
+                        detail::space_type current_space_id(H5Dget_space(raii_id));                                                                                     \
+                        if (H5Sget_simple_extent_type(current_space_id) != H5S_SIMPLE                                                                                   \
+                            || detail::check_error(H5Sget_simple_extent_ndims(current_space_id)) != static_cast<int>(size.size())                                       \
+                        )                                                                                                                                               \
+                            throw archive_error("the dataset has the wrong dimensions to be appended to: " + path + ALPS_STACKTRACE);                                   \
+                        detail::check_error(H5Sget_simple_extent_dims(current_space_id, &current_hid.front(), &max_hid.front()));                                       \
+                    }                                                                                                                                                   \
+                    if (max_hid[0] != H5S_UNLIMITED)                                                                                                                    \
+                        throw archive_error("the dataset is not appendable: " + path + ALPS_STACKTRACE);                                                                \
+                    if (!std::equal(size_hid.begin() + 1, size_hid.end(), current_hid.begin() + 1) || !is_datatype<T>(path))                                            \
+                        throw archive_error("the block does not match the dataset: " + path + ALPS_STACKTRACE);                                                         \
+                    offset_hid[0] = current_hid[0];                                                                                                                     \
+                    extent_hid[0] = current_hid[0] + size_hid[0];                                                                                                       \
+                    detail::check_error(H5Dset_extent(raii_id, &extent_hid.front()));                                                                                   \
+                }                                                                                                                                                       \
+                detail::native_ptr_converter<T> converter(std::accumulate(size.begin(), size.end(), std::size_t(1), std::multiplies<std::size_t>()));                   \
+                detail::space_type space_id(H5Dget_space(raii_id));                                                                                                     \
+                detail::check_error(H5Sselect_hyperslab(space_id, H5S_SELECT_SET, &offset_hid.front(), NULL, &size_hid.front(), NULL));                                 \
+                detail::space_type mem_id(H5Screate_simple(static_cast<int>(size_hid.size()), &size_hid.front(), NULL));                                                \
+                detail::check_error(H5Dwrite(raii_id, type_id, mem_id, space_id, H5P_DEFAULT, converter.apply(value)));                                                 \
+            }
+        ALPS_FOREACH_NATIVE_HDF5_TYPE(ALPS_HDF5_APPEND_VECTOR)
+        #undef ALPS_HDF5_APPEND_VECTOR
+
         #define ALPS_HDF5_IMPLEMENT_FREE_FUNCTIONS(T)                                                                                                                   \
             namespace detail {                                                                                                                                          \
                 alps::hdf5::scalar_type< T >::type * get_pointer< T >::apply( T & value) {                                                                              \
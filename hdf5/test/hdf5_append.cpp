@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+#include <alps/hdf5/archive.hpp>
+#include <alps/hdf5/vector.hpp>
+#include <alps/testing/unique_file.hpp>
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+class TestHDF5Append : public ::testing::Test {
+  public:
+    std::string fname_;
+
+    TestHDF5Append() {
+        fname_=alps::testing::temporary_filename("append.h5.");
+    }
+
+    ~TestHDF5Append() {
+        if (!fname_.empty()) remove(fname_.c_str());
+    }
+};
+
+namespace ah5=alps::hdf5;
+
+TEST_F(TestHDF5Append, Rows) {
+    std::vector<double> block(3*4);
+    for (std::size_t i=0; i<block.size(); ++i) block[i]=i;
+    {
+        ah5::archive ar(fname_,"w");
+        ar.append("/series/data", &block[0], std::vector<std::size_t>{3, 4}, std::vector<std::size_t>{8, 4});
+        ar.append("/series/data", &block[4], std::vector<std::size_t>{2, 4});
+    }
+    {
+        ah5::archive ar(fname_,"a");
+        ar.append("/series/data", &block[0], std::vector<std::size_t>{1, 4});
+    }
+    ah5::archive ar(fname_,"r");
+    ASSERT_EQ((std::vector<std::size_t>{6, 4}), ar.extent("/series/data"));
+    std::vector<std::vector<double> > data;
+    ar["/series/data"] >> data;
+    ASSERT_EQ(6u, data.size());
+    for (std::size_t j=0; j<4; ++j) {
+        EXPECT_EQ(block[j], data[0][j]);
+        EXPECT_EQ(block[8+j], data[2][j]);
+        EXPECT_EQ(block[4+j], data[3][j]);
+        EXPECT_EQ(block[8+j], data[4][j]);
+        EXPECT_EQ(block[j], data[5][j]);
+    }
+}
+
+TEST_F(TestHDF5Append, Scalars) {
+    std::vector<int> values(10);
+    for (std::size_t i=0; i<values.size(); ++i) values[i]=2*i;
+    ah5::archive ar(fname_,"w");
+    ar.append("/values", &values[0], std::vector<std::size_t>(1, 4));
+    ar.append("/values", &values[4], std::vector<std::size_t>(1, 6));
+    std::vector<int> data;
+    ar["/values"] >> data;
+    EXPECT_EQ(values, data);
+}
+
+TEST_F(TestHDF5Append, Mismatch) {
+    std::vector<double> block(8, 1.);
+    ah5::archive ar(fname_,"w");
+    ar["/fixed"] << block;
+    EXPECT_THROW(ar.append("/fixed", &block[0], std::vector<std::size_t>(1, 8)), ah5::archive_error);
+    ar.append("/series", &block[0], std::vector<std::size_t>{2, 4});
+    EXPECT_THROW(ar.append("/series", &block[0], std::vector<std::size_t>{2, 3}), ah5::archive_error);
+    EXPECT_THROW(ar.append("/series", &block[0], std::vector<std::size_t>(1, 8)), ah5::archive_error);
+    EXPECT_EQ((std::vector<std::size_t>{2, 4}), ar.extent("/series"));
+}
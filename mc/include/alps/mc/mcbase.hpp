@@ -45,6 +45,12 @@ namespace alps {
             results_type collect_results() const;
             results_type collect_results(result_names_type const & names) const;
 
+            /// The observables measured on this process, e.g. to check their convergence with `convergence_callback`
+            observable_collection_type const & observables() const { return measurements; }
+
+            /// Writes a checkpoint to `filename`
+            /** Successive checkpoints to the same file update it: only the accumulators
+                which changed since the previous checkpoint are written. */
             void save(std::string const & filename) const;
             void load(std::string const & filename);
             virtual void save(alps::hdf5::archive & ar) const;
@@ -56,6 +62,11 @@ namespace alps {
             // parameters_type & params; // TODO: deprecated, remove!
             alps::random01 random;
             observable_collection_type measurements;
+
+        private:
+
+            /// The file of the last checkpoint, which is updated by the next one to the same file
+            mutable std::string last_checkpoint;
     };
 
     
@@ -16,6 +16,9 @@
 #include <alps/accumulators/mpi.hpp>
 #include <alps/mc/check_schedule.hpp>
 
+#include <algorithm>
+#include <stdexcept>
+
 namespace alps {
 
     namespace detail {
@@ -64,26 +67,27 @@ namespace alps {
                 return collect_results(this->result_names());
             }
 
+            /// Merge the observables `names` of all processes, and return their results on the process 0
+            /** All observables are merged together by a few collective operations,
+                see `accumulator_set::collective_merge()`. */
             typename Base::results_type collect_results(typename Base::result_names_type const & names) const {
+                // the set shares the accumulators with the measurements
+                typename Base::observable_collection_type selected;
+                for(typename Base::observable_collection_type::const_iterator it = this->measurements.begin(); it != this->measurements.end(); ++it)
+                    if (std::find(names.begin(), names.end(), it->first) != names.end())
+                        selected.insert(it->first, it->second);
+                for(typename Base::result_names_type::const_iterator it = names.begin(); it != names.end(); ++it)
+                    if (!selected.has(*it))
+                        throw std::out_of_range("No observable found with the name: " + *it + ALPS_STACKTRACE);
+
                 typename Base::results_type partial_results;
-                for(typename Base::result_names_type::const_iterator it = names.begin(); it != names.end(); ++it) {
-                    size_t has_count=(this->measurements[*it].count() > 0);
-                    const size_t sum_counts =
-                            alps::mpi::all_reduce(communicator,
-                                                  has_count,
-                                                  std::plus<size_t>());
-                    if (static_cast<int>(sum_counts) == communicator.size()) {
-                        if (communicator.rank() == 0) {
-                            typename Base::observable_collection_type::value_type merged = this->measurements[*it];
-                            merged.collective_merge(communicator, 0);
-                            partial_results.insert(*it, merged.result());
-                        } else {
-                            this->measurements[*it].collective_merge(communicator, 0);
-                        }
-                    } else if (sum_counts > 0 && static_cast<int>(sum_counts) < communicator.size()) {
-                        throw std::runtime_error(*it + " was measured on only some of the MPI processes.");
-                    }
-                }
+                if (communicator.rank() == 0) {
+                    selected.collective_merge(communicator, 0);
+                    for(typename Base::observable_collection_type::const_iterator it = selected.begin(); it != selected.end(); ++it)
+                        if (it->second->count() > 0)
+                            partial_results.insert(it->first, it->second->result());
+                } else
+                    static_cast<typename Base::observable_collection_type const &>(selected).collective_merge(communicator, 0);
                 return partial_results;
             }
 
@@ -11,6 +11,11 @@
 #include <alps/utilities/signal.hpp>
 
 #include <alps/mc/check_schedule.hpp>
+#include <alps/accumulators.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
 
 #ifdef ALPS_HAVE_MPI
 #include <boost/optional.hpp>
@@ -71,6 +76,56 @@ namespace alps {
 		    const time_duration_type limit;
 		    const time_point_type start;
 	};
+
+        /// Functor-predicate:  is it time to stop?
+        /** The functor returns `true` when `stop_callback` would, or when the error
+            bars of all the target observables have converged to their target
+            relative precision (see `accumulator_wrapper::reached_precision()`).
+            The targets need a binning analysis, e.g. `LogBinningAccumulator` or
+            `FullBinningAccumulator`. Usage:
+
+                sim.run(alps::convergence_callback(sim.observables(), timelimit)
+                            .target("Energy", 1E-3)
+                            .target("Magnetization", 1E-2));
+        */
+	class convergence_callback {
+                private:
+                    typedef std::vector< std::pair<std::string, double> > targets_type;
+
+		public:
+                    /// Initializes the functor with the observables and the desired time duration
+                    /** @param measurements Observables of the simulation (see `mcbase::observables()`)
+                        @param timelimit Time limit (seconds); 0 means "until converged"
+                    */
+		    convergence_callback(alps::accumulators::accumulator_set const & measurements, std::size_t timelimit);
+#ifdef ALPS_HAVE_MPI
+                    /// Initializes the functor with the observables and the desired time duration
+                    /** Each process checks its own observables. With P processes, the error bar of
+                        the merged observables is about 1/sqrt(P) of the error bar on each process,
+                        so each one checks for sqrt(P) times the target relative error.
+                        @param cm MPI communicator to determine the root process
+                        @param measurements Observables of the simulation on this process
+                        @param timelimit Time limit (seconds); 0 means "until converged"
+                     */
+                    convergence_callback(alps::mpi::communicator const & cm, alps::accumulators::accumulator_set const & measurements, std::size_t timelimit);
+#endif
+                    /// Adds the observable `name`, which converges when its error bar is at most `relative_error` times its mean
+                    convergence_callback & target(std::string const & name, double relative_error);
+
+                    /// Returns `true` if it's time to stop (time is up, signal is received or all targets converged)
+                    /** Without targets, only time and signals stop the simulation. */
+		    bool operator()() const;
+		private:
+                    /// Whether all targets reached `scale` times their relative error
+                    bool converged(double scale) const;
+
+                    stop_callback timer;
+                    alps::accumulators::accumulator_set const & measurements;
+                    targets_type targets;
+#ifdef ALPS_HAVE_MPI
+                    boost::optional<alps::mpi::communicator> comm;
+#endif
+	};
 }
 
 #endif
@@ -21,8 +21,9 @@ namespace alps {
     }
 
   void mcbase::save(std::string const & filename) const {
-        alps::hdf5::archive ar(filename, "w");
+        alps::hdf5::archive ar(filename, filename == last_checkpoint ? "a" : "w");
         ar["/simulation/realizations/0/clones/0"] << *this;
+        last_checkpoint = filename;
     }
 
     void mcbase::load(std::string const & filename) {
@@ -8,6 +8,10 @@
 
 #include <alps/utilities/signal.hpp>
 #include <alps/utilities/boost_mpi.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#include <cmath>
+#include <stdexcept>
 
 namespace alps {
 
@@ -47,4 +51,49 @@ namespace alps {
         time_point_type now(clock_type::now_time());
         return (limit > 0 && clock_type::time_diff(now, start) >= limit);
     }
+
+
+    convergence_callback::convergence_callback(alps::accumulators::accumulator_set const & measurements_, std::size_t timelimit)
+        : timer(timelimit)
+        , measurements(measurements_)
+    {}
+
+#ifdef ALPS_HAVE_MPI
+    convergence_callback::convergence_callback(alps::mpi::communicator const & cm, alps::accumulators::accumulator_set const & measurements_, std::size_t timelimit)
+        : timer(timelimit), measurements(measurements_), comm(cm)
+    {}
+#endif
+
+    convergence_callback & convergence_callback::target(std::string const & name, double relative_error) {
+        targets.push_back(std::make_pair(name, relative_error));
+        return *this;
+    }
+
+    bool convergence_callback::operator()() const {
+#ifdef ALPS_HAVE_MPI
+        if (comm) {
+            int unconverged = converged(std::sqrt(double(comm->size()))) ? 0 : 1;
+            unconverged = alps::mpi::all_reduce(*comm, unconverged, alps::mpi::maximum<int>());
+            bool to_stop = false;
+            if (comm->rank() == 0) {
+                to_stop = timer() || !unconverged;
+            }
+            broadcast(*comm, to_stop, 0);
+            return to_stop;
+        } else
+#endif
+            return timer() || converged(1.);
+    }
+
+    bool convergence_callback::converged(double scale) const {
+        if (targets.empty())
+            return false;
+        for (targets_type::const_iterator it = targets.begin(); it != targets.end(); ++it) {
+            if (!measurements.has(it->first))
+                throw std::out_of_range("No observable found with the name: " + it->first + ALPS_STACKTRACE);
+            if (!measurements[it->first].reached_precision(scale * it->second))
+                return false;
+        }
+        return true;
+    }
 }
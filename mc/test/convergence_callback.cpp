@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/* This is to test the convergence callback together with the MC scheduler */
+
+#include <alps/mc/mcbase.hpp>
+#include <alps/mc/api.hpp>
+#include <alps/mc/stop_callback.hpp>
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+class noisy_sim : public alps::mcbase {
+    long count_;
+  public:
+    static const long HOW_LONG=100000000;
+    noisy_sim(const parameters_type& p) : alps::mcbase(p), count_(0)
+    {
+        measurements << alps::accumulators::FullBinningAccumulator<double>("X")
+                     << alps::accumulators::LogBinningAccumulator<std::vector<double> >("V")
+                     << alps::accumulators::NoBinningAccumulator<double>("Y");
+    }
+
+    void update() { ++count_; }
+
+    void measure() {
+        const double x=1.+random()-0.5;
+        measurements["X"] << x;
+        measurements["V"] << std::vector<double>(2, 2.*x);
+        measurements["Y"] << x;
+    }
+
+    double fraction_completed() const {
+        return count_/double(HOW_LONG);
+    }
+
+    long count() const { return count_; }
+};
+
+class ConvergenceCallbackTest : public ::testing::Test {
+  public:
+    alps::params param_;
+    noisy_sim sim_;
+
+    ConvergenceCallbackTest() : param_(), sim_((param_["SEED"]=43,param_)) {}
+};
+
+TEST_F(ConvergenceCallbackTest, StopsWhenConverged) {
+    bool completed=sim_.run(alps::convergence_callback(sim_.observables(), 0)
+                                .target("X", 0.005)
+                                .target("V", 0.01));
+    EXPECT_FALSE(completed);
+    EXPECT_LT(sim_.count(), noisy_sim::HOW_LONG);
+
+    alps::accumulators::result_set results=alps::collect_results(sim_);
+    EXPECT_LE(results["X"].error<double>(), 0.00505*std::fabs(results["X"].mean<double>()));
+    EXPECT_LE(results["V"].error<std::vector<double> >()[0], 0.0101*std::fabs(results["V"].mean<std::vector<double> >()[0]));
+}
+
+TEST_F(ConvergenceCallbackTest, UnknownTarget) {
+    EXPECT_THROW(sim_.run(alps::convergence_callback(sim_.observables(), 0).target("Z", 0.1)), std::out_of_range);
+}
+
+TEST_F(ConvergenceCallbackTest, NoBinningAnalysis) {
+    EXPECT_THROW(sim_.run(alps::convergence_callback(sim_.observables(), 0).target("Y", 0.1)), std::runtime_error);
+}
@@ -52,8 +52,9 @@ int main(int argc, char** argv)
             const aa::result_wrapper& mag4=results["Magnetization^4"];
             const aa::result_wrapper& mag2=results["Magnetization^2"];
 
-            // Compute Binder cumulant:
-            aa::result_wrapper binder_cumulant=1-mag4/(3*mag2*mag2);
+            // Compute Binder cumulant; `lazy()` defers the arithmetic, which is
+            // then evaluated in a single pass over the bins of mag4 and mag2:
+            aa::result_wrapper binder_cumulant=1-aa::lazy(mag4)/(3*aa::lazy(mag2)*aa::lazy(mag2));
 
             // Output the results:
             std::cout << p["temperature"].as<double>() << " "
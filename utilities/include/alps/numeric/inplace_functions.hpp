@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file inplace_functions.hpp
+    @brief Fused in-place arithmetic kernels used on the accumulation hot path
+
+    The generic versions fall back to the `alps::numeric` operators. The overloads
+    for `std::vector` of arithmetic types write into the existing storage of the
+    destination with plain loops (which the compiler can vectorize) and never
+    allocate once the destination has reached its final size. Element by element,
+    they perform the same floating point operations as the operator expressions
+    they replace, so the results are bitwise identical.
+*/
+
+#ifndef ALPS_NUMERIC_INPLACE_FUNCTIONS_HPP
+#define ALPS_NUMERIC_INPLACE_FUNCTIONS_HPP
+
+#include <alps/numeric/vector_functions.hpp>
+#include <alps/numeric/check_size.hpp>
+#include <alps/utilities/stacktrace.hpp>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/throw_exception.hpp>
+#include <boost/type_traits/is_arithmetic.hpp>
+#include <boost/utility/enable_if.hpp>
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+namespace alps {
+    namespace numeric {
+
+        namespace detail {
+            inline void check_same_size(std::size_t lsize, std::size_t rsize) {
+                if (lsize != rsize) {
+                    boost::throw_exception(std::runtime_error("std::vectors have different sizes:"
+                                                              " left=" + boost::lexical_cast<std::string>(lsize) +
+                                                              " right=" + boost::lexical_cast<std::string>(rsize) + "\n" +
+                                                              ALPS_STACKTRACE));
+                }
+            }
+        }
+
+        /// Accumulate `x` into `acc`: `acc += x` (generic version)
+        template<typename A, typename X>
+        inline void add_to(A & acc, X const & x) {
+            using alps::numeric::operator+=;
+            acc += x;
+        }
+
+        /// Accumulate `x` into `acc` element by element
+        template<typename T>
+        inline typename boost::enable_if<boost::is_arithmetic<T> >::type
+        add_to(std::vector<T> & acc, std::vector<T> const & x) {
+            detail::check_same_size(acc.size(), x.size());
+            T * a = acc.empty() ? 0 : &acc[0];
+            T const * v = x.empty() ? 0 : &x[0];
+            for (std::size_t i = 0, n = x.size(); i < n; ++i)
+                a[i] += v[i];
+        }
+
+        /// Accumulate the square of `x` into `acc`: `acc += x * x` (generic version)
+        template<typename A, typename X>
+        inline void add_square(A & acc, X const & x) {
+            using alps::numeric::operator*;
+            using alps::numeric::operator+=;
+            acc += x * x;
+        }
+
+        /// Accumulate the element-wise square of `x` into `acc` without a temporary vector
+        template<typename T>
+        inline typename boost::enable_if<boost::is_arithmetic<T> >::type
+        add_square(std::vector<T> & acc, std::vector<T> const & x) {
+            detail::check_same_size(acc.size(), x.size());
+            T * a = acc.empty() ? 0 : &acc[0];
+            T const * v = x.empty() ? 0 : &x[0];
+            for (std::size_t i = 0, n = x.size(); i < n; ++i)
+                a[i] += v[i] * v[i];
+        }
+
+        /// Set `a` to zero, shaped like `like` (generic version)
+        template<typename A, typename X>
+        inline void set_zero_like(A & a, X const & like) {
+            a = A();
+            check_size(a, like);
+        }
+
+        /// Set all elements of `a` to zero, resizing it to the size of `like`; keeps the storage of `a`
+        template<typename T, typename U>
+        inline typename boost::enable_if<boost::is_arithmetic<T> >::type
+        set_zero_like(std::vector<T> & a, std::vector<U> const & like) {
+            a.assign(like.size(), T());
+        }
+
+        /// Assign the pairwise average `dst = (x + y) / two` (generic version); `dst` may alias `x` or `y`
+        template<typename D, typename X, typename S>
+        inline void assign_pair_average(D & dst, X const & x, X const & y, S const & two) {
+            using alps::numeric::operator+;
+            using alps::numeric::operator/;
+            dst = (x + y) / two;
+        }
+
+        /// Assign the element-wise pairwise average into the storage of `dst`; `dst` may alias `x` or `y`
+        template<typename T>
+        inline typename boost::enable_if<boost::is_arithmetic<T> >::type
+        assign_pair_average(std::vector<T> & dst, std::vector<T> const & x, std::vector<T> const & y, T const & two) {
+            if (x.size() != y.size()) {
+                // default-initialized operands are treated as 0-vectors by the operators
+                using alps::numeric::operator+;
+                using alps::numeric::operator/;
+                dst = (x + y) / two;
+                return;
+            }
+            dst.resize(x.size());
+            T * d = dst.empty() ? 0 : &dst[0];
+            T const * a = x.empty() ? 0 : &x[0];
+            T const * b = y.empty() ? 0 : &y[0];
+            for (std::size_t i = 0, n = x.size(); i < n; ++i)
+                d[i] = (a[i] + b[i]) / two;
+        }
+
+        /// Assign the quotient `dst = x / s` (generic version)
+        template<typename D, typename X, typename S>
+        inline void assign_divided(D & dst, X const & x, S const & s) {
+            using alps::numeric::operator/;
+            dst = x / s;
+        }
+
+        /// Assign the element-wise quotient into the storage of `dst`
+        template<typename T>
+        inline typename boost::enable_if<boost::is_arithmetic<T> >::type
+        assign_divided(std::vector<T> & dst, std::vector<T> const & x, T const & s) {
+            dst.resize(x.size());
+            T * d = dst.empty() ? 0 : &dst[0];
+            T const * v = x.empty() ? 0 : &x[0];
+            for (std::size_t i = 0, n = x.size(); i < n; ++i)
+                d[i] = v[i] / s;
+        }
+
+    }
+}
+
+#endif // ALPS_NUMERIC_INPLACE_FUNCTIONS_HPP
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 1998-2018 ALPS Collaboration. See COPYRIGHT.TXT
+ * All rights reserved. Use is subject to license terms. See LICENSE.TXT
+ * For use in publications, see ACKNOWLEDGE.TXT
+ */
+
+/** @file inplace_functions.cpp
+    Test that the in-place kernels give the same results as the operator expressions
+*/
+
+#include <vector>
+#include "alps/numeric/inplace_functions.hpp"
+
+#include "gtest/gtest.h"
+
+namespace an=alps::numeric;
+
+namespace {
+    std::vector<double> make_vector(std::size_t n, double offset) {
+        std::vector<double> v(n);
+        for (std::size_t i=0; i<n; ++i) v[i]=offset+0.1*i-1./(i+3);
+        return v;
+    }
+}
+
+TEST(InplaceFunctions, AddSquareScalar) {
+    double acc=1.25, x=0.3;
+    an::add_square(acc, x);
+    EXPECT_EQ(1.25+0.3*0.3, acc);
+}
+
+TEST(InplaceFunctions, AddSquareVector) {
+    using an::operator*;
+    using an::operator+=;
+    std::vector<double> x=make_vector(17, 0.5);
+    std::vector<double> expected=make_vector(17, 2.);
+    std::vector<double> acc=expected;
+    expected += x*x;
+
+    const double* storage=&acc[0];
+    an::add_square(acc, x);
+    EXPECT_EQ(expected, acc);
+    EXPECT_EQ(storage, &acc[0]);
+
+    std::vector<double> wrong(3);
+    EXPECT_THROW(an::add_square(wrong, x), std::runtime_error);
+}
+
+TEST(InplaceFunctions, SetZeroLike) {
+    std::vector<double> like(5, 1.);
+    std::vector<double> a(5, 3.);
+    const double* storage=&a[0];
+    an::set_zero_like(a, like);
+    EXPECT_EQ(std::vector<double>(5, 0.), a);
+    EXPECT_EQ(storage, &a[0]);
+
+    std::vector<double> empty;
+    an::set_zero_like(empty, like);
+    EXPECT_EQ(std::vector<double>(5, 0.), empty);
+
+    double s=2.;
+    an::set_zero_like(s, 1.);
+    EXPECT_EQ(0., s);
+}
+
+TEST(InplaceFunctions, PairAverage) {
+    using an::operator+;
+    using an::operator/;
+    std::vector<double> x=make_vector(9, 0.7), y=make_vector(9, -1.1);
+    std::vector<double> expected=(x+y)/2.;
+
+    std::vector<double> dst(9);
+    an::assign_pair_average(dst, x, y, 2.);
+    EXPECT_EQ(expected, dst);
+
+    // the destination may alias an argument
+    an::assign_pair_average(x, x, y, 2.);
+    EXPECT_EQ(expected, x);
+
+    // an empty operand is treated as zero, like by the operators
+    std::vector<double> empty;
+    an::assign_pair_average(dst, empty, y, 2.);
+    EXPECT_EQ(y/2., dst);
+}
+
+TEST(InplaceFunctions, Divided) {
+    using an::operator/;
+    std::vector<double> x=make_vector(11, 0.3);
+    std::vector<double> dst(11);
+    const double* storage=&dst[0];
+    an::assign_divided(dst, x, 3.);
+    EXPECT_EQ(x/3., dst);
+    EXPECT_EQ(storage, &dst[0]);
+
+    double s=0;
+    an::assign_divided(s, 1., 4.);
+    EXPECT_EQ(0.25, s);
+}